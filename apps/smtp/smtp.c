@@ -92,9 +92,9 @@ PT_THREAD(smtp_thread(void))
     PSOCK_EXIT(&s.psock);
   }
   
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_helo);
-  PSOCK_SEND_STR(&s.psock, localhostname);
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_crnl);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_helo);
+  PSOCK_WRITE_STR(&s.psock, localhostname);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnl);
 
   PSOCK_READTO(&s.psock, ISO_nl);
   
@@ -104,9 +104,9 @@ PT_THREAD(smtp_thread(void))
     PSOCK_EXIT(&s.psock);
   }
 
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_mail_from);
-  PSOCK_SEND_STR(&s.psock, s.from);
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_crnl);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_mail_from);
+  PSOCK_WRITE_STR(&s.psock, s.from);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnl);
 
   PSOCK_READTO(&s.psock, ISO_nl);
   
@@ -116,9 +116,9 @@ PT_THREAD(smtp_thread(void))
     PSOCK_EXIT(&s.psock);
   }
 
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_rcpt_to);
-  PSOCK_SEND_STR(&s.psock, s.to);
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_crnl);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_rcpt_to);
+  PSOCK_WRITE_STR(&s.psock, s.to);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnl);
 
   PSOCK_READTO(&s.psock, ISO_nl);
   
@@ -129,9 +129,9 @@ PT_THREAD(smtp_thread(void))
   }
   
   if(s.cc != 0) {
-    PSOCK_SEND_STR(&s.psock, (char *)smtp_rcpt_to);
-    PSOCK_SEND_STR(&s.psock, s.cc);
-    PSOCK_SEND_STR(&s.psock, (char *)smtp_crnl);
+    PSOCK_WRITE_STR(&s.psock, (char *)smtp_rcpt_to);
+    PSOCK_WRITE_STR(&s.psock, s.cc);
+    PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnl);
 
     PSOCK_READTO(&s.psock, ISO_nl);
   
@@ -142,7 +142,7 @@ PT_THREAD(smtp_thread(void))
     }
   }
   
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_data);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_data);
   
   PSOCK_READTO(&s.psock, ISO_nl);
   
@@ -152,27 +152,27 @@ PT_THREAD(smtp_thread(void))
     PSOCK_EXIT(&s.psock);
   }
 
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_to);
-  PSOCK_SEND_STR(&s.psock, s.to);
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_crnl);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_to);
+  PSOCK_WRITE_STR(&s.psock, s.to);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnl);
   
   if(s.cc != 0) {
-    PSOCK_SEND_STR(&s.psock, (char *)smtp_cc);
-    PSOCK_SEND_STR(&s.psock, s.cc);
-    PSOCK_SEND_STR(&s.psock, (char *)smtp_crnl);
+    PSOCK_WRITE_STR(&s.psock, (char *)smtp_cc);
+    PSOCK_WRITE_STR(&s.psock, s.cc);
+    PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnl);
   }
   
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_from);
-  PSOCK_SEND_STR(&s.psock, s.from);
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_crnl);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_from);
+  PSOCK_WRITE_STR(&s.psock, s.from);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnl);
   
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_subject);
-  PSOCK_SEND_STR(&s.psock, s.subject);
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_crnl);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_subject);
+  PSOCK_WRITE_STR(&s.psock, s.subject);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnl);
 
-  PSOCK_SEND(&s.psock, s.msg, s.msglen);
+  PSOCK_WRITE(&s.psock, s.msg, s.msglen);
   
-  PSOCK_SEND_STR(&s.psock, (char *)smtp_crnlperiodcrnl);
+  PSOCK_WRITE_STR(&s.psock, (char *)smtp_crnlperiodcrnl);
 
   PSOCK_READTO(&s.psock, ISO_nl);
   if(s.inputbuffer[0] != ISO_2) {
@@ -235,7 +235,7 @@ smtp_send(char *to, char *cc, char *from,
 {
   struct uip_conn *conn;
 
-  conn = uip_connect(smtpserver, HTONS(25));
+  conn = uip_connect(&smtpserver, HTONS(25));
   if(conn == NULL) {
     return 0;
   }
@@ -248,6 +248,7 @@ smtp_send(char *to, char *cc, char *from,
   s.msglen = msglen;
 
   PSOCK_INIT(&s.psock, s.inputbuffer, sizeof(s.inputbuffer));
+  PSOCK_OUTBUF(&s.psock, s.outputbuffer, sizeof(s.outputbuffer));
   
   return 1;
 }
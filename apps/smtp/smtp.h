@@ -48,6 +48,7 @@
 #define __SMTP_H__
 
 #include "uipopt.h"
+#include "psock.h"
 
 /**
  * Error number that signifies a non-error condition.
@@ -69,8 +70,8 @@ void smtp_done(unsigned char error);
 void smtp_init(void);
 
 /* Functions. */
-void smtp_configure(char *localhostname, u16_t *smtpserver);
-unsigned char smtp_send(char *to, char *from,
+void smtp_configure(char *localhostname, void *smtpserver);
+unsigned char smtp_send(char *to, char *cc, char *from,
 			char *subject, char *msg,
 			u16_t msglen);
 #define SMTP_SEND(to, cc, from, subject, msg) \
@@ -80,7 +81,12 @@ void smtp_appcall(void);
 
 struct smtp_state {
   u8_t state;
+  u8_t connected;
+  struct psock psock;
+  char inputbuffer[4];
+  char outputbuffer[128];
   char *to;
+  char *cc;
   char *from;
   char *subject;
   char *msg;
@@ -85,6 +85,8 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
     if(httpd_fs_strcmp(name, f->name) == 0) {
       file->data = f->data;
       file->len = f->len;
+      file->base = f->data;
+      file->sums = f->sums;
 #if HTTPD_FS_STATISTICS
       ++count[i];
 #endif /* HTTPD_FS_STATISTICS */
@@ -98,6 +100,47 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
   return 0;
 }
 /*-----------------------------------------------------------------------------------*/
+static u16_t
+chksum_add(u16_t a, u16_t b)
+{
+  a += b;
+  return (a < b) ? a + 1 : a;
+}
+/*-----------------------------------------------------------------------------------*/
+u16_t
+httpd_fs_chksum(const struct httpd_fs_file *file, int len)
+{
+  int off, first, last;
+  u16_t sum;
+
+  off = file->data - file->base;
+  first = (off + HTTPD_FS_CHUNK - 1) / HTTPD_FS_CHUNK;
+  last = (off + len) / HTTPD_FS_CHUNK;
+  if(first >= last) {
+    return ntohs(uip_chksum((u16_t *)file->data, len));
+  }
+
+  /* sums[i] is the sum of the first i chunks, so the sum of the
+     chunks from first to last is the difference of two sums. The
+     rest of the last chunk is added to it. */
+  sum = chksum_add(file->sums[last], (u16_t)~file->sums[first]);
+  sum = chksum_add(sum,
+		   ntohs(uip_chksum((u16_t *)&file->base[last * HTTPD_FS_CHUNK],
+				    off + len - last * HTTPD_FS_CHUNK)));
+
+  /* The chunks are summed from the start of the file. If the data
+     starts at an odd offset, they are at odd offsets in the data, so
+     their sum is byte swapped. */
+  if(off & 1) {
+    sum = (sum << 8) | (sum >> 8);
+  }
+
+  /* Add the part of the first chunk. */
+  return chksum_add(sum,
+		    ntohs(uip_chksum((u16_t *)file->data,
+				     first * HTTPD_FS_CHUNK - off)));
+}
+/*-----------------------------------------------------------------------------------*/
 void
 httpd_fs_init(void)
 {
@@ -40,12 +40,20 @@
 struct httpd_fs_file {
   char *data;
   int len;
+  char *base;     /* The start of the file. */
+  u16_t *sums;    /* The sums of the file up to each chunk. */
 };
 
 /* file must be allocated by caller and will be filled in
    by the function. */
 int httpd_fs_open(const char *name, struct httpd_fs_file *file);
 
+/* Returns the one's complement sum of the next len bytes of the
+   file, in host byte order. Only the parts of the first and last
+   chunk are summed; the rest comes from the sums computed by
+   makefsdata. */
+u16_t httpd_fs_chksum(const struct httpd_fs_file *file, int len);
+
 #ifdef HTTPD_FS_STATISTICS
 #if HTTPD_FS_STATISTICS == 1
 u16_t httpd_fs_count(char *name);
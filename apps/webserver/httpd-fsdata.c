@@ -23,6 +23,10 @@ static const unsigned char data_processes_shtml[] = {
 	0x73, 0xa, 0x25, 0x21, 0x3a, 0x20, 0x2f, 0x66, 0x6f, 0x6f, 
 	0x74, 0x65, 0x72, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 0};
 
+static const u16_t sums_processes_shtml[] = {
+	0x0000, 0x8e63, 0x07b6, 0x2182,
+};
+
 static const unsigned char data_404_html[] = {
 	/* /404.html */
 	0x2f, 0x34, 0x30, 0x34, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 0,
@@ -44,6 +48,10 @@ static const unsigned char data_404_html[] = {
 	0x79, 0x3e, 0xa, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 
 0};
 
+static const u16_t sums_404_html[] = {
+	0x0000, 0xea14, 0x3a58,
+};
+
 static const unsigned char data_files_shtml[] = {
 	/* /files.shtml */
 	0x2f, 0x66, 0x69, 0x6c, 0x65, 0x73, 0x2e, 0x73, 0x68, 0x74, 0x6d, 0x6c, 0,
@@ -174,12 +182,22 @@ static const unsigned char data_files_shtml[] = {
 	0x2f, 0x66, 0x6f, 0x6f, 0x74, 0x65, 0x72, 0x2e, 0x68, 0x74, 
 	0x6d, 0x6c, 0xa, 0};
 
+static const u16_t sums_files_shtml[] = {
+	0x0000, 0x2b1f, 0x3997, 0x1ef5, 0xab10, 0x2e9f, 0x1374, 0x7e10,
+	0x80d4, 0x18d2, 0xa788, 0x9fb3, 0x5d38, 0x5357, 0x1e5b, 0xc762,
+	0x831f, 0xde73, 0xe51a, 0x74f5,
+};
+
 static const unsigned char data_footer_html[] = {
 	/* /footer.html */
 	0x2f, 0x66, 0x6f, 0x6f, 0x74, 0x65, 0x72, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 0,
 	0x20, 0x20, 0x3c, 0x2f, 0x62, 0x6f, 0x64, 0x79, 0x3e, 0xa, 
 	0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0};
 
+static const u16_t sums_footer_html[] = {
+	0x0000,
+};
+
 static const unsigned char data_header_html[] = {
 	/* /header.html */
 	0x2f, 0x68, 0x65, 0x61, 0x64, 0x65, 0x72, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 0,
@@ -247,6 +265,11 @@ static const unsigned char data_header_html[] = {
 	0x73, 0x3d, 0x22, 0x63, 0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74, 
 	0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x22, 0x3e, 0xa, 0};
 
+static const u16_t sums_header_html[] = {
+	0x0000, 0xdd55, 0x86e5, 0x0d1e, 0xd5bf, 0x3e2e, 0xa36d, 0x45ae,
+	0x20e1, 0xb2a6,
+};
+
 static const unsigned char data_index_html[] = {
 	/* /index.html */
 	0x2f, 0x69, 0x6e, 0x64, 0x65, 0x78, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 0,
@@ -339,6 +362,11 @@ static const unsigned char data_index_html[] = {
 	0x6f, 0x64, 0x79, 0x3e, 0xa, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 
 	0x6c, 0x3e, 0xa, 0};
 
+static const u16_t sums_index_html[] = {
+	0x0000, 0xdd55, 0x86e5, 0x0d1e, 0xd5bf, 0x3e2e, 0xa36d, 0x45ae,
+	0x20e1, 0xb2a6, 0x308b, 0x4708, 0x6de4, 0x16f5,
+};
+
 static const unsigned char data_style_css[] = {
 	/* /style.css */
 	0x2f, 0x73, 0x74, 0x79, 0x6c, 0x65, 0x2e, 0x63, 0x73, 0x73, 0,
@@ -445,6 +473,11 @@ static const unsigned char data_style_css[] = {
 	0x67, 0x6e, 0x3a, 0x72, 0x69, 0x67, 0x68, 0x74, 0x3b, 0x20, 
 	0xa, 0x7d, 0xa, 0xa, 0};
 
+static const u16_t sums_style_css[] = {
+	0x0000, 0xbd20, 0x0abe, 0xc624, 0xfe68, 0xb3aa, 0x33be, 0x2b11,
+	0x685c, 0x8ef1, 0x3b10, 0x406e, 0xb95a, 0xcb4b, 0xbe5f, 0x3b1a,
+};
+
 static const unsigned char data_tcp_shtml[] = {
 	/* /tcp.shtml */
 	0x2f, 0x74, 0x63, 0x70, 0x2e, 0x73, 0x68, 0x74, 0x6d, 0x6c, 0,
@@ -471,6 +504,10 @@ static const unsigned char data_tcp_shtml[] = {
 	0x6f, 0x6f, 0x74, 0x65, 0x72, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 
 0};
 
+static const u16_t sums_tcp_shtml[] = {
+	0x0000, 0x0691, 0xec2d, 0x462b,
+};
+
 static const unsigned char data_fade_png[] = {
 	/* /fade.png */
 	0x2f, 0x66, 0x61, 0x64, 0x65, 0x2e, 0x70, 0x6e, 0x67, 0,
@@ -495,6 +532,10 @@ static const unsigned char data_fade_png[] = {
 	0xa1, 0xf3, 0xfc, 0x73, 00, 00, 00, 00, 0x49, 0x45, 
 	0x4e, 0x44, 0xae, 0x42, 0x60, 0x82, 0};
 
+static const u16_t sums_fade_png[] = {
+	0x0000, 0xd7e7, 0x559d, 0xeb61,
+};
+
 static const unsigned char data_stats_shtml[] = {
 	/* /stats.shtml */
 	0x2f, 0x73, 0x74, 0x61, 0x74, 0x73, 0x2e, 0x73, 0x68, 0x74, 0x6d, 0x6c, 0,
@@ -582,25 +623,32 @@ static const unsigned char data_stats_shtml[] = {
 	0x6f, 0x6f, 0x74, 0x65, 0x72, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 
 	0xa, 0};
 
-const struct httpd_fsdata_file file_processes_shtml[] = {{NULL, data_processes_shtml, data_processes_shtml + 17, sizeof(data_processes_shtml) - 17}};
+static const u16_t sums_stats_shtml[] = {
+	0x0000, 0x6e2d, 0x9f3d, 0x1b27, 0xdb67, 0x7201, 0x8f54, 0xe5df,
+	0xcd93, 0xb341, 0x6763, 0x39ec, 0x3916,
+};
+
+const struct httpd_fsdata_file file_processes_shtml[] = {{NULL, data_processes_shtml, data_processes_shtml + 17, sizeof(data_processes_shtml) - 17, sums_processes_shtml}};
+
+const struct httpd_fsdata_file file_404_html[] = {{file_processes_shtml, data_404_html, data_404_html + 10, sizeof(data_404_html) - 10, sums_404_html}};
 
-const struct httpd_fsdata_file file_404_html[] = {{file_processes_shtml, data_404_html, data_404_html + 10, sizeof(data_404_html) - 10}};
+const struct httpd_fsdata_file file_files_shtml[] = {{file_404_html, data_files_shtml, data_files_shtml + 13, sizeof(data_files_shtml) - 13, sums_files_shtml}};
 
-const struct httpd_fsdata_file file_files_shtml[] = {{file_404_html, data_files_shtml, data_files_shtml + 13, sizeof(data_files_shtml) - 13}};
+const struct httpd_fsdata_file file_footer_html[] = {{file_files_shtml, data_footer_html, data_footer_html + 13, sizeof(data_footer_html) - 13, sums_footer_html}};
 
-const struct httpd_fsdata_file file_footer_html[] = {{file_files_shtml, data_footer_html, data_footer_html + 13, sizeof(data_footer_html) - 13}};
+const struct httpd_fsdata_file file_header_html[] = {{file_footer_html, data_header_html, data_header_html + 13, sizeof(data_header_html) - 13, sums_header_html}};
 
-const struct httpd_fsdata_file file_header_html[] = {{file_footer_html, data_header_html, data_header_html + 13, sizeof(data_header_html) - 13}};
+const struct httpd_fsdata_file file_index_html[] = {{file_header_html, data_index_html, data_index_html + 12, sizeof(data_index_html) - 12, sums_index_html}};
 
-const struct httpd_fsdata_file file_index_html[] = {{file_header_html, data_index_html, data_index_html + 12, sizeof(data_index_html) - 12}};
+const struct httpd_fsdata_file file_style_css[] = {{file_index_html, data_style_css, data_style_css + 11, sizeof(data_style_css) - 11, sums_style_css}};
 
-const struct httpd_fsdata_file file_style_css[] = {{file_index_html, data_style_css, data_style_css + 11, sizeof(data_style_css) - 11}};
+const struct httpd_fsdata_file file_tcp_shtml[] = {{file_style_css, data_tcp_shtml, data_tcp_shtml + 11, sizeof(data_tcp_shtml) - 11, sums_tcp_shtml}};
 
-const struct httpd_fsdata_file file_tcp_shtml[] = {{file_style_css, data_tcp_shtml, data_tcp_shtml + 11, sizeof(data_tcp_shtml) - 11}};
+const struct httpd_fsdata_file file_fade_png[] = {{file_tcp_shtml, data_fade_png, data_fade_png + 10, sizeof(data_fade_png) - 10, sums_fade_png}};
 
-const struct httpd_fsdata_file file_fade_png[] = {{file_tcp_shtml, data_fade_png, data_fade_png + 10, sizeof(data_fade_png) - 10}};
+const struct httpd_fsdata_file file_stats_shtml[] = {{file_fade_png, data_stats_shtml, data_stats_shtml + 13, sizeof(data_stats_shtml) - 13, sums_stats_shtml}};
 
-const struct httpd_fsdata_file file_stats_shtml[] = {{file_fade_png, data_stats_shtml, data_stats_shtml + 13, sizeof(data_stats_shtml) - 13}};
+#define HTTPD_FS_CHUNK 64
 
 #define HTTPD_FS_ROOT file_stats_shtml
 
@@ -42,6 +42,7 @@ struct httpd_fsdata_file {
   const char *name;
   const char *data;
   const int len;
+  const u16_t *sums;
 #ifdef HTTPD_FS_STATISTICS
 #if HTTPD_FS_STATISTICS == 1
   u16_t count;
@@ -54,6 +55,7 @@ struct httpd_fsdata_file_noconst {
   char *name;
   char *data;
   int len;
+  u16_t *sums;
 #ifdef HTTPD_FS_STATISTICS
 #if HTTPD_FS_STATISTICS == 1
   u16_t count;
@@ -56,6 +56,7 @@
  */
 
 #include "uip.h"
+#include "uip-sendbuf.h"
 #include "httpd.h"
 #include "httpd-fs.h"
 #include "httpd-cgi.h"
@@ -75,21 +76,6 @@
 #define ISO_colon   0x3a
 
 
-/*---------------------------------------------------------------------------*/
-static unsigned short
-generate_part_of_file(void *state)
-{
-  struct httpd_state *s = (struct httpd_state *)state;
-
-  if(s->file.len > uip_mss()) {
-    s->len = uip_mss();
-  } else {
-    s->len = s->file.len;
-  }
-  memcpy(uip_appdata, s->file.data, s->len);
-  
-  return s->len;
-}
 /*---------------------------------------------------------------------------*/
 static
 PT_THREAD(send_file(struct httpd_state *s))
@@ -97,7 +83,21 @@ PT_THREAD(send_file(struct httpd_state *s))
   PSOCK_BEGIN(&s->sout);
   
   do {
-    PSOCK_GENERATOR_SEND(&s->sout, generate_part_of_file, s);
+    /* The file data is constant, so it is handed to the socket as it
+       is rather than copied into uip_appdata by a generator. */
+    if(s->file.len > uip_mss()) {
+      s->len = uip_mss();
+    } else {
+      s->len = s->file.len;
+    }
+#if UIP_ZEROCOPY
+    /* The sum of the data is taken from the file system, so only
+       the headers are summed for the TCP checksum. */
+    PSOCK_SEND_SUM(&s->sout, s->file.data, s->len,
+		   httpd_fs_chksum(&s->file, s->len));
+#else /* UIP_ZEROCOPY */
+    PSOCK_SEND(&s->sout, s->file.data, s->len);
+#endif /* UIP_ZEROCOPY */
     s->file.len -= s->len;
     s->file.data += s->len;
   } while(s->file.len > 0);
@@ -191,24 +191,24 @@ PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
 
   PSOCK_BEGIN(&s->sout);
 
-  PSOCK_SEND_STR(&s->sout, statushdr);
+  PSOCK_WRITE_STR(&s->sout, statushdr);
 
   ptr = strrchr(s->filename, ISO_period);
   if(ptr == NULL) {
-    PSOCK_SEND_STR(&s->sout, http_content_type_binary);
+    PSOCK_WRITE_STR(&s->sout, http_content_type_binary);
   } else if(strncmp(http_html, ptr, 5) == 0 ||
 	    strncmp(http_shtml, ptr, 6) == 0) {
-    PSOCK_SEND_STR(&s->sout, http_content_type_html);
+    PSOCK_WRITE_STR(&s->sout, http_content_type_html);
   } else if(strncmp(http_css, ptr, 4) == 0) {
-    PSOCK_SEND_STR(&s->sout, http_content_type_css);
+    PSOCK_WRITE_STR(&s->sout, http_content_type_css);
   } else if(strncmp(http_png, ptr, 4) == 0) {
-    PSOCK_SEND_STR(&s->sout, http_content_type_png);
+    PSOCK_WRITE_STR(&s->sout, http_content_type_png);
   } else if(strncmp(http_gif, ptr, 4) == 0) {
-    PSOCK_SEND_STR(&s->sout, http_content_type_gif);
+    PSOCK_WRITE_STR(&s->sout, http_content_type_gif);
   } else if(strncmp(http_jpg, ptr, 4) == 0) {
-    PSOCK_SEND_STR(&s->sout, http_content_type_jpg);
+    PSOCK_WRITE_STR(&s->sout, http_content_type_jpg);
   } else {
-    PSOCK_SEND_STR(&s->sout, http_content_type_plain);
+    PSOCK_WRITE_STR(&s->sout, http_content_type_plain);
   }
   PSOCK_END(&s->sout);
 }
@@ -241,7 +241,11 @@ PT_THREAD(handle_output(struct httpd_state *s))
 		     send_file(s));
     }
   }
+  PT_WAIT_THREAD(&s->outputpt, psock_flush(&s->sout));
   PSOCK_CLOSE(&s->sout);
+  /* With a send buffer, the connection stays open until the buffer
+     has drained, and the output must not start over meanwhile. */
+  s->state = STATE_WAITING;
   PT_END(&s->outputpt);
 }
 /*---------------------------------------------------------------------------*/
@@ -273,13 +277,10 @@ PT_THREAD(handle_input(struct httpd_state *s))
   
   s->state = STATE_OUTPUT;
 
+  /* None of the request header is used, so it is skipped without
+     being copied into the input buffer. */
   while(1) {
-    PSOCK_READTO(&s->sin, ISO_nl);
-
-    if(strncmp(s->inputbuf, http_referer, 8) == 0) {
-      s->inputbuf[PSOCK_DATALEN(&s->sin) - 2] = 0;
-      /*      httpd_log(&s->inputbuf[9]);*/
-    }
+    PSOCK_SKIPTO_EMPTYLINE(&s->sin);
   }
   
   PSOCK_END(&s->sin);
@@ -301,8 +302,16 @@ httpd_appcall(void)
 
   if(uip_closed() || uip_aborted() || uip_timedout()) {
   } else if(uip_connected()) {
+#if UIP_TCP_SENDBUFS
+    /* If all send buffers are in use, the data is sent one segment
+       at a time as usual. */
+    uip_sendbuf_alloc();
+#endif /* UIP_TCP_SENDBUFS */
     PSOCK_INIT(&s->sin, s->inputbuf, sizeof(s->inputbuf) - 1);
     PSOCK_INIT(&s->sout, s->inputbuf, sizeof(s->inputbuf) - 1);
+#if HTTPD_OUTBUF_SIZE > 0
+    PSOCK_OUTBUF(&s->sout, s->outputbuf, sizeof(s->outputbuf));
+#endif /* HTTPD_OUTBUF_SIZE > 0 */
     PT_INIT(&s->outputpt);
     s->state = STATE_WAITING;
     /*    timer_set(&s->timer, CLOCK_SECOND * 100);*/
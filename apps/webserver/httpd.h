@@ -38,11 +38,23 @@
 #include "psock.h"
 #include "httpd-fs.h"
 
+/* The size of the buffer in which the response headers are collected
+   so that they go out in one segment, or 0 to send every header line
+   by itself. */
+#ifdef HTTPD_CONF_OUTBUF_SIZE
+#define HTTPD_OUTBUF_SIZE HTTPD_CONF_OUTBUF_SIZE
+#else /* HTTPD_CONF_OUTBUF_SIZE */
+#define HTTPD_OUTBUF_SIZE 0
+#endif /* HTTPD_CONF_OUTBUF_SIZE */
+
 struct httpd_state {
   unsigned char timer;
   struct psock sin, sout;
   struct pt outputpt, scriptpt;
   char inputbuf[50];
+#if HTTPD_OUTBUF_SIZE > 0
+  char outputbuf[HTTPD_OUTBUF_SIZE];
+#endif /* HTTPD_OUTBUF_SIZE > 0 */
   char filename[20];
   char state;
   struct httpd_fs_file file;
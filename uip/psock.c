@@ -39,6 +39,7 @@
 #include "uipopt.h"
 #include "psock.h"
 #include "uip.h"
+#include "uip-sendbuf.h"
 
 #define STATE_NONE 0
 #define STATE_ACKED 1
@@ -70,6 +71,38 @@
  */
 #define BUF_FOUND 2
 
+/*
+ * Send s->sendlen bytes from s->sendptr and wait until they have been
+ * acknowledged. The macro blocks the protothread, so each use of it
+ * must be on a line of its own.
+ *
+ */
+#define SEND_AND_WAIT(s)						\
+  do {									\
+    (s)->state = STATE_NONE;						\
+    while((s)->sendlen > 0) {						\
+      PT_WAIT_UNTIL(&(s)->psockpt, data_sent_and_acked(s));	\
+    }									\
+    (s)->state = STATE_NONE;						\
+  } while(0)
+
+/*
+ * Send the data in the output buffer, if there is any. The buffer is
+ * emptied only after the data has been acknowledged, or copied to the
+ * send buffer of the connection, since it may be needed for a
+ * retransmission.
+ *
+ */
+#define FLUSH(s)					\
+  do {							\
+    if((s)->outlen > 0) {				\
+      (s)->sendptr = (u8_t *)(s)->outbuf;		\
+      (s)->sendlen = (s)->outlen;			\
+      SEND_AND_WAIT(s);					\
+      (s)->outlen = 0;					\
+    }							\
+  } while(0)
+
 /*---------------------------------------------------------------------------*/
 static void
 buf_setup(struct psock_buf *buf,
@@ -111,68 +144,158 @@ static u8_t
 buf_bufto(register struct psock_buf *buf, u8_t endmarker,
 	  register u8_t **dataptr, register u16_t *datalen)
 {
-  u8_t c;
-  while(buf->left > 0 && *datalen > 0) {
-    c = *buf->ptr = **dataptr;
-    ++*dataptr;
-    ++buf->ptr;
-    --*datalen;
-    --buf->left;
-    
-    if(c == endmarker) {
-      return BUF_FOUND;
-    }
+  u8_t *end;
+  u16_t len;
+
+  /* Look for the end marker in the part of the data that fits in the
+     buffer, and copy the data up to and including the marker. */
+  len = *datalen < buf->left? *datalen: buf->left;
+  end = memchr(*dataptr, endmarker, len);
+  if(end != NULL) {
+    len = end - *dataptr + 1;
+  }
+  memcpy(buf->ptr, *dataptr, len);
+  buf->ptr += len;
+  buf->left -= len;
+  *dataptr += len;
+  *datalen -= len;
+
+  if(end != NULL) {
+    return BUF_FOUND;
   }
 
   if(*datalen == 0) {
     return BUF_NOT_FOUND;
   }
 
-  while(*datalen > 0) {
-    c = **dataptr;
-    --*datalen;
-    ++*dataptr;
-    
-    if(c == endmarker) {
-      return BUF_FOUND | BUF_FULL;
-    }
+  /* The buffer is full, so the data up to the end marker is
+     dropped. */
+  end = memchr(*dataptr, endmarker, *datalen);
+  if(end != NULL) {
+    len = end - *dataptr + 1;
+    *dataptr += len;
+    *datalen -= len;
+    return BUF_FOUND | BUF_FULL;
   }
-  
+  *dataptr += *datalen;
+  *datalen = 0;
+
   return BUF_FULL;
 }
 /*---------------------------------------------------------------------------*/
-static char
+static u8_t
+buf_skipline(register struct psock *psock)
+{
+  u8_t *ptr, *nl;
+  u16_t len;
+  u8_t ret;
+
+  ptr = psock->readptr;
+  len = psock->readlen;
+  ret = BUF_NOT_FOUND;
+  while(len > 0) {
+    /* A carriage return that starts a line is part of its line
+       break. */
+    if(!psock->linedata && *ptr == '\r') {
+      ++ptr;
+      --len;
+      continue;
+    }
+
+    nl = memchr(ptr, '\n', len);
+    if(nl == NULL) {
+      psock->linedata = 1;
+      ptr += len;
+      len = 0;
+      break;
+    }
+
+    if(nl != ptr) {
+      psock->linedata = 1;
+    }
+    len -= nl - ptr + 1;
+    ptr = nl + 1;
+
+    if(!psock->linedata) {
+      ret = BUF_FOUND;
+      break;
+    }
+    psock->linedata = 0;
+  }
+
+  psock->readptr = ptr;
+  psock->readlen = len;
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static void
 send_data(register struct psock *s)
 {
   if(s->state != STATE_DATA_SENT || uip_rexmit()) {
-    if(s->sendlen > uip_mss()) {
-      uip_send(s->sendptr, uip_mss());
+    /* The MSS follows the window of the remote end, so the length of
+       the segment is remembered for when it is acknowledged. */
+    s->seglen = s->sendlen > uip_mss()? uip_mss(): s->sendlen;
+#if UIP_ZEROCOPY
+    /* The data stays in place until it has been acknowledged, so it
+       is sent from where it is instead of being copied. Data made by
+       a generator is in uip_buf, which does not stay in place, and
+       is copied as usual. */
+    if((u8_t *)s->sendptr >= &uip_buf[0] &&
+       (u8_t *)s->sendptr < &uip_buf[UIP_BUFSIZE]) {
+      uip_send(s->sendptr, s->seglen);
+    } else if(s->seglen == s->sumlen && s->outlen == 0) {
+      /* All the data given to PSOCK_SEND_SUM() fits in the segment,
+	 and it is not the output buffer that is being flushed. */
+      uip_sendrefsum(s->sendptr, s->seglen, s->sendsum);
     } else {
-      uip_send(s->sendptr, s->sendlen);
+      uip_sendref(s->sendptr, s->seglen);
     }
+#else /* UIP_ZEROCOPY */
+    uip_send(s->sendptr, s->seglen);
+#endif /* UIP_ZEROCOPY */
     s->state = STATE_DATA_SENT;
-    return 1;
   }
-  return 0;
 }
 /*---------------------------------------------------------------------------*/
 static char
 data_acked(register struct psock *s)
 {
   if(s->state == STATE_DATA_SENT && uip_acked()) {
-    if(s->sendlen > uip_mss()) {
-      s->sendlen -= uip_mss();
-      s->sendptr += uip_mss();
-    } else {
-      s->sendptr += s->sendlen;
-      s->sendlen = 0;
-    }
+    s->sendptr += s->seglen;
+    s->sendlen -= s->seglen;
     s->state = STATE_ACKED;
     return 1;
   }
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+static char
+data_sent_and_acked(register struct psock *s)
+{
+#if UIP_TCP_SENDBUFS
+  u16_t n;
+
+  if(uip_sendbuf_used()) {
+    /* uIP sends and retransmits the data from the send buffer, so we
+       only wait for there to be room for it. */
+    n = uip_sendbuf_write(s->sendptr, s->sendlen);
+    s->sendptr += n;
+    s->sendlen -= n;
+    return s->sendlen == 0;
+  }
+#endif /* UIP_TCP_SENDBUFS */
+
+  /* An acknowledgment is only taken as such once. The next segment
+     is sent when the condition is evaluated again, with the
+     acknowledgment still flagged, so it must not be counted for that
+     segment too. */
+  if(data_acked(s)) {
+    return 1;
+  }
+  send_data(s);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 PT_THREAD(psock_send(register struct psock *s, const char *buf,
 		     unsigned int len))
 {
@@ -183,6 +306,9 @@ PT_THREAD(psock_send(register struct psock *s, const char *buf,
     PT_EXIT(&s->psockpt);
   }
 
+  /* Data written with PSOCK_WRITE() goes out first. */
+  FLUSH(s);
+
   /* Save the length of and a pointer to the data that is to be
      sent. */
   s->sendptr = buf;
@@ -195,19 +321,17 @@ PT_THREAD(psock_send(register struct psock *s, const char *buf,
   while(s->sendlen > 0) {
 
     /*
-     * The condition for this PT_WAIT_UNTIL is a little tricky: the
-     * protothread will wait here until all data has been acknowledged
-     * (data_acked() returns true) and until all data has been sent
-     * (send_data() returns true). The two functions data_acked() and
-     * send_data() must be called in succession to ensure that all
-     * data is sent. Therefore the & operator is used instead of the
-     * && operator, which would cause only the data_acked() function
-     * to be called when it returns false.
+     * The protothread waits here until the segment that was sent last
+     * has been acknowledged (data_sent_and_acked() returns true). The
+     * loop then comes back here, where the next segment is sent.
      */
-    PT_WAIT_UNTIL(&s->psockpt, data_acked(s) & send_data(s));
+    PT_WAIT_UNTIL(&s->psockpt, data_sent_and_acked(s));
   }
 
   s->state = STATE_NONE;
+#if UIP_ZEROCOPY
+  s->sumlen = 0;
+#endif /* UIP_ZEROCOPY */
   
   PT_END(&s->psockpt);
 }
@@ -222,6 +346,21 @@ PT_THREAD(psock_generator_send(register struct psock *s,
     PT_EXIT(&s->psockpt);
   }
 
+  /* The output buffer is flushed before the generator overwrites the
+     uip_appdata buffer. */
+  FLUSH(s);
+
+#if UIP_TCP_SENDBUFS
+  if(uip_sendbuf_used()) {
+    /* The generated data is copied to the send buffer right away, so
+       the generator is called once there is room for a full segment
+       and is not called again for retransmissions. */
+    PT_WAIT_UNTIL(&s->psockpt, uip_sendbuf_room() >= uip_mss());
+    uip_sendbuf_write(uip_appdata, generate(arg));
+    PT_EXIT(&s->psockpt);
+  }
+#endif /* UIP_TCP_SENDBUFS */
+
   /* Call the generator function to generate the data in the
      uip_appdata buffer. */
   s->sendlen = generate(arg);
@@ -235,7 +374,7 @@ PT_THREAD(psock_generator_send(register struct psock *s,
       generate(arg);
     }
     /* Wait until all data is sent and acknowledged. */
-    PT_WAIT_UNTIL(&s->psockpt, data_acked(s) & send_data(s));
+    PT_WAIT_UNTIL(&s->psockpt, data_sent_and_acked(s));
   } while(s->sendlen > 0);
   
   s->state = STATE_NONE;
@@ -243,6 +382,43 @@ PT_THREAD(psock_generator_send(register struct psock *s,
   PT_END(&s->psockpt);
 }
 /*---------------------------------------------------------------------------*/
+PT_THREAD(psock_write(register struct psock *s, const char *buf,
+		      unsigned int len))
+{
+  PT_BEGIN(&s->psockpt);
+
+  /* If there is no data to write, we exit immediately. */
+  if(len == 0) {
+    PT_EXIT(&s->psockpt);
+  }
+
+  /* Make room for the data if it does not fit behind what is already
+     in the output buffer. */
+  if(s->outlen + len > s->outsize) {
+    FLUSH(s);
+  }
+
+  if(len > s->outsize) {
+    /* The data does not fit even in an empty buffer, so it is sent
+       from where it is. */
+    s->sendptr = (u8_t *)buf;
+    s->sendlen = len;
+    SEND_AND_WAIT(s);
+  } else {
+    memcpy(s->outbuf + s->outlen, buf, len);
+    s->outlen += len;
+  }
+
+  PT_END(&s->psockpt);
+}
+/*---------------------------------------------------------------------------*/
+PT_THREAD(psock_flush(register struct psock *s))
+{
+  PT_BEGIN(&s->psockpt);
+  FLUSH(s);
+  PT_END(&s->psockpt);
+}
+/*---------------------------------------------------------------------------*/
 u16_t
 psock_datalen(struct psock *psock)
 {
@@ -273,6 +449,9 @@ PT_THREAD(psock_readto(register struct psock *psock, unsigned char c))
 {
   PT_BEGIN(&psock->psockpt);
 
+  /* Whatever the remote end is to answer must have been sent. */
+  FLUSH(psock);
+
   buf_setup(&psock->buf, psock->bufptr, psock->bufsize);
   
   /* XXX: Should add buf_checkmarker() before do{} loop, if
@@ -296,10 +475,36 @@ PT_THREAD(psock_readto(register struct psock *psock, unsigned char c))
   PT_END(&psock->psockpt);
 }
 /*---------------------------------------------------------------------------*/
+PT_THREAD(psock_skipto_emptyline(register struct psock *psock))
+{
+  PT_BEGIN(&psock->psockpt);
+
+  /* Whatever the remote end is to answer must have been sent. */
+  FLUSH(psock);
+
+  /* The data is not buffered, so the input buffer stays empty. */
+  buf_setup(&psock->buf, (u8_t *)psock->bufptr, psock->bufsize);
+  psock->linedata = 0;
+
+  do {
+    if(psock->readlen == 0) {
+      PT_WAIT_UNTIL(&psock->psockpt, psock_newdata(psock));
+      psock->state = STATE_READ;
+      psock->readptr = (u8_t *)uip_appdata;
+      psock->readlen = uip_datalen();
+    }
+  } while(buf_skipline(psock) != BUF_FOUND);
+
+  PT_END(&psock->psockpt);
+}
+/*---------------------------------------------------------------------------*/
 PT_THREAD(psock_readbuf(register struct psock *psock))
 {
   PT_BEGIN(&psock->psockpt);
 
+  /* Whatever the remote end is to answer must have been sent. */
+  FLUSH(psock);
+
   buf_setup(&psock->buf, psock->bufptr, psock->bufsize);
   
   /* XXX: Should add buf_checkmarker() before do{} loop, if
@@ -329,6 +534,11 @@ psock_init(register struct psock *psock, char *buffer, unsigned int buffersize)
 {
   psock->state = STATE_NONE;
   psock->readlen = 0;
+#if UIP_ZEROCOPY
+  psock->sumlen = 0;
+#endif /* UIP_ZEROCOPY */
+  psock->outbuf = NULL;
+  psock->outsize = psock->outlen = 0;
   psock->bufptr = buffer;
   psock->bufsize = buffersize;
   buf_setup(&psock->buf, buffer, buffersize);
@@ -336,3 +546,12 @@ psock_init(register struct psock *psock, char *buffer, unsigned int buffersize)
   PT_INIT(&psock->psockpt);
 }
 /*---------------------------------------------------------------------------*/
+void
+psock_outbuf(register struct psock *psock, char *buffer,
+	     unsigned int buffersize)
+{
+  psock->outbuf = buffer;
+  psock->outsize = buffersize;
+  psock->outlen = 0;
+}
+/*---------------------------------------------------------------------------*/
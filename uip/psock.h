@@ -114,13 +114,29 @@ struct psock {
 			    incoming data. */
   
   u16_t sendlen;         /* The number of bytes left to be sent. */
+  u16_t seglen;          /* The number of bytes in the segment that
+			    was last sent. */
+  /* UIP_CONF_ZEROCOPY is tested as this file can be read from
+     uip-conf.h, before uipopt.h has defined UIP_ZEROCOPY. */
+#if UIP_CONF_ZEROCOPY
+  u16_t sendsum, sumlen; /* The sum of the data given to
+			    PSOCK_SEND_SUM(), and its length. */
+#endif /* UIP_CONF_ZEROCOPY */
   u16_t readlen;         /* The number of bytes left to be read. */
 
+  char *outbuf;          /* Pointer to the buffer used for buffering
+			    outgoing data. */
+  u16_t outsize, outlen; /* The size of the output buffer, and the
+			    number of bytes in it. */
+
   struct psock_buf buf;  /* The structure holding the state of the
 			    input buffer. */
   unsigned int bufsize;  /* The size of the input buffer. */
   
   unsigned char state;   /* The state of the protosocket. */
+  unsigned char linedata; /* Non-zero if PSOCK_SKIPTO_EMPTYLINE() has
+			     seen anything but a line break on the
+			     current line. */
 };
 
 void psock_init(struct psock *psock, char *buffer, unsigned int buffersize);
@@ -144,6 +160,29 @@ void psock_init(struct psock *psock, char *buffer, unsigned int buffersize);
 #define PSOCK_INIT(psock, buffer, buffersize) \
   psock_init(psock, buffer, buffersize)
 
+void psock_outbuf(struct psock *psock, char *buffer, unsigned int buffersize);
+/**
+ * Give a protosocket an output buffer.
+ *
+ * This macro specifies a buffer in which data written with
+ * PSOCK_WRITE() is collected, so that several small writes go out
+ * in one segment instead of one segment, and one round-trip, each.
+ * The buffer should be no larger than the MSS of the connection. The
+ * macro must be called after PSOCK_INIT(), which leaves the
+ * protosocket without an output buffer.
+ *
+ * \param psock (struct psock *) A pointer to the protosocket.
+ *
+ * \param buffer (char *) A pointer to the output buffer for the
+ * protosocket.
+ *
+ * \param buffersize (unsigned int) The size of the output buffer.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_OUTBUF(psock, buffer, buffersize) \
+  psock_outbuf(psock, buffer, buffersize)
+
 /**
  * Start the protosocket protothread in a function.
  *
@@ -178,6 +217,39 @@ PT_THREAD(psock_send(struct psock *psock, const char *buf, unsigned int len));
 #define PSOCK_SEND(psock, data, datalen)		\
     PT_WAIT_THREAD(&((psock)->pt), psock_send(psock, data, datalen))
 
+/**
+ * Send data whose sum is known.
+ *
+ * This macro works like PSOCK_SEND(), but also takes the one's
+ * complement sum of the data, as passed to uip_sendrefsum(). If uIP
+ * is configured with UIP_ZEROCOPY, the sum is used when the data fits
+ * in a single segment, so uIP need not sum the data to compute the
+ * TCP checksum.
+ *
+ * \param psock (struct psock *) A pointer to the protosocket over which
+ * data is to be sent.
+ *
+ * \param data (char *) A pointer to the data that is to be sent.
+ *
+ * \param datalen (unsigned int) The length of the data that is to be
+ * sent.
+ *
+ * \param sum (u16_t) The one's complement sum of the data.
+ *
+ * \hideinitializer
+ */
+#if UIP_CONF_ZEROCOPY
+#define PSOCK_SEND_SUM(psock, data, datalen, sum)	\
+  do {							\
+    (psock)->sendsum = (sum);				\
+    (psock)->sumlen = (datalen);			\
+    PSOCK_SEND(psock, data, datalen);			\
+  } while(0)
+#else /* UIP_CONF_ZEROCOPY */
+#define PSOCK_SEND_SUM(psock, data, datalen, sum)	\
+  PSOCK_SEND(psock, data, datalen)
+#endif /* UIP_CONF_ZEROCOPY */
+
 /**
  * \brief      Send a null-terminated string.
  * \param psock Pointer to the protosocket.
@@ -191,6 +263,61 @@ PT_THREAD(psock_send(struct psock *psock, const char *buf, unsigned int len));
 #define PSOCK_SEND_STR(psock, str)      		\
     PT_WAIT_THREAD(&((psock)->pt), psock_send(psock, str, strlen(str)))
 
+PT_THREAD(psock_write(struct psock *psock, const char *buf, unsigned int len));
+/**
+ * Write data to the output buffer.
+ *
+ * This macro copies data into the output buffer given with
+ * PSOCK_OUTBUF() and returns without blocking if the data fits. If
+ * it does not fit, the buffered data is sent first, and data that is
+ * larger than the whole buffer is sent directly, as with
+ * PSOCK_SEND().
+ *
+ * Buffered data is sent by PSOCK_FLUSH(), and before the data of any
+ * of the other send and read functions, so output is never held
+ * back while the protosocket waits for the remote end. It must be
+ * flushed explicitly before the connection is closed.
+ *
+ * \param psock (struct psock *) A pointer to the protosocket over which
+ * data is to be sent.
+ *
+ * \param data (char *) A pointer to the data that is to be written.
+ *
+ * \param datalen (unsigned int) The length of the data that is to be
+ * written.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_WRITE(psock, data, datalen)		\
+    PT_WAIT_THREAD(&((psock)->pt), psock_write(psock, data, datalen))
+
+/**
+ * \brief      Write a null-terminated string to the output buffer.
+ * \param psock Pointer to the protosocket.
+ * \param str  The string to be written.
+ *
+ *             This function works like PSOCK_WRITE(), for a
+ *             null-terminated string.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_WRITE_STR(psock, str)      		\
+    PT_WAIT_THREAD(&((psock)->pt), psock_write(psock, str, strlen(str)))
+
+PT_THREAD(psock_flush(struct psock *psock));
+/**
+ * Send the data in the output buffer.
+ *
+ * This macro sends the data collected by PSOCK_WRITE() and blocks
+ * until it has been acknowledged by the remote end.
+ *
+ * \param psock (struct psock *) A pointer to the protosocket.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_FLUSH(psock)				\
+  PT_WAIT_THREAD(&((psock)->pt), psock_flush(psock))
+
 PT_THREAD(psock_generator_send(struct psock *psock,
 				unsigned short (*f)(void *), void *arg));
 
@@ -268,6 +395,24 @@ PT_THREAD(psock_readto(struct psock *psock, unsigned char c));
 #define PSOCK_READTO(psock, c)				\
   PT_WAIT_THREAD(&((psock)->pt), psock_readto(psock, c))
 
+PT_THREAD(psock_skipto_emptyline(struct psock *psock));
+/**
+ * Skip data up to and including the next empty line.
+ *
+ * This macro will block waiting for data and discard it until a line
+ * with nothing but its line break in it has been received, such as
+ * the line that ends the header of an HTTP request. The data is not
+ * copied to the input buffer, and PSOCK_DATALEN() is zero
+ * afterwards.
+ *
+ * \param psock (struct psock *) A pointer to the protosocket from which
+ * data should be skipped.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_SKIPTO_EMPTYLINE(psock)			\
+  PT_WAIT_THREAD(&((psock)->pt), psock_skipto_emptyline(psock))
+
 /**
  * The length of the data that was previously read.
  *
@@ -123,5 +123,29 @@ timer_expired(struct timer *t)
   return (clock_time_t)(clock_time() - t->start) >= (clock_time_t)t->interval;
 }
 /*---------------------------------------------------------------------------*/
+/**
+ * The time until a timer expires.
+ *
+ * This function returns the time until the timer expires, so that a
+ * system that sleeps when idle knows how long it may sleep.
+ *
+ * \param t A pointer to the timer
+ *
+ * \return The time until the timer expires, or zero if it has
+ * expired.
+ *
+ */
+clock_time_t
+timer_remaining(struct timer *t)
+{
+  clock_time_t elapsed;
+
+  elapsed = clock_time() - t->start;
+  if(elapsed >= (clock_time_t)t->interval) {
+    return 0;
+  }
+  return t->interval - elapsed;
+}
+/*---------------------------------------------------------------------------*/
 
 /** @} */
@@ -80,6 +80,7 @@ void timer_set(struct timer *t, clock_time_t interval);
 void timer_reset(struct timer *t);
 void timer_restart(struct timer *t);
 int timer_expired(struct timer *t);
+clock_time_t timer_remaining(struct timer *t);
 
 #endif /* __TIMER_H__ */
 
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+/**
+ * \addtogroup uipcc
+ * @{
+ */
+
+/**
+ * \file
+ * TCP congestion control: slow start, fast retransmit, NewReno fast
+ * recovery and the NewReno and CUBIC congestion avoidance
+ * algorithms.
+ */
+
+#include "uip-cc.h"
+#include "clock.h"
+
+#if UIP_TCP_CC
+
+#ifdef UIP_CC_CONF_DEFAULT
+#define DEFAULT_CC UIP_CC_CONF_DEFAULT
+#else /* UIP_CC_CONF_DEFAULT */
+#define DEFAULT_CC uip_cc_newreno
+#endif /* UIP_CC_CONF_DEFAULT */
+
+/* The number of duplicate acknowledgments that triggers a fast
+   retransmit. */
+#define DUPACK_THRESHOLD 3
+
+/* Values of the ->recovery field of the connection. */
+#define RECOVERY_FAST 1
+#define RECOVERY_RTO  2
+
+/*---------------------------------------------------------------------------*/
+static u16_t
+sat_add(u16_t a, u16_t b)
+{
+  return a > 0xffff - b? 0xffff: a + b;
+}
+/*---------------------------------------------------------------------------*/
+static void
+slow_start(struct uip_conn *conn, u16_t acked)
+{
+  /* Grow the window by the amount of data acknowledged, but by no
+     more than one segment per acknowledgment (RFC 3465, L = 1). */
+  conn->cwnd = sat_add(conn->cwnd, acked > conn->mss? conn->mss: acked);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_cc_init(struct uip_conn *conn)
+{
+  /* The initial window is min(4 * MSS, max(2 * MSS, 4380 bytes)) as
+     per RFC 3390. */
+  if(conn->initialmss > 2190) {
+    conn->cwnd = sat_add(conn->initialmss, conn->initialmss);
+  } else if(conn->initialmss > 1095) {
+    conn->cwnd = 4380;
+  } else {
+    conn->cwnd = 4 * conn->initialmss;
+  }
+  conn->ssthresh = 0xffff;
+  conn->dupacks = 0;
+  conn->recovery = 0;
+  conn->cc = &DEFAULT_CC;
+  conn->cc->init(conn);
+}
+/*---------------------------------------------------------------------------*/
+u8_t
+uip_cc_ack(struct uip_conn *conn, u16_t acked)
+{
+  conn->dupacks = 0;
+
+  if(conn->recovery != 0) {
+    if(acked < conn->recover) {
+      /* A partial acknowledgment: the segment that follows the
+	 acknowledged data was lost as well and is retransmitted
+	 right away. */
+      conn->recover -= acked;
+      if(conn->recovery == RECOVERY_FAST) {
+	/* Deflate the window by the amount of data acknowledged and
+	   add back one segment (RFC 6582). */
+	conn->cwnd = conn->cwnd > acked? conn->cwnd - acked: 0;
+	conn->cwnd = sat_add(conn->cwnd, conn->mss);
+      } else {
+	slow_start(conn, acked);
+      }
+      return 1;
+    }
+
+    /* All data that was in flight when the loss was detected has
+       been acknowledged. */
+    if(conn->recovery == RECOVERY_FAST) {
+      conn->cwnd = conn->ssthresh;
+      if(conn->cwnd > sat_add(conn->len, conn->mss)) {
+	conn->cwnd = sat_add(conn->len, conn->mss);
+      }
+    }
+    conn->recovery = 0;
+    return 0;
+  }
+
+  if(conn->cwnd < conn->ssthresh) {
+    slow_start(conn, acked);
+  } else {
+    conn->cc->cong_avoid(conn, acked);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+u8_t
+uip_cc_dupack(struct uip_conn *conn)
+{
+  if(conn->recovery == RECOVERY_FAST) {
+    /* Every duplicate acknowledgment tells us that another segment
+       has left the network, so we inflate the window. */
+    conn->cwnd = sat_add(conn->cwnd, conn->mss);
+    return 0;
+  }
+
+  if(conn->recovery == 0 && ++conn->dupacks == DUPACK_THRESHOLD) {
+    /* Fast retransmit, and enter fast recovery. */
+    conn->ssthresh = conn->cc->ssthresh(conn);
+    conn->cwnd = sat_add(conn->ssthresh, 3 * conn->mss);
+    conn->recover = conn->len;
+    conn->recovery = RECOVERY_FAST;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_cc_timeout(struct uip_conn *conn)
+{
+  /* Repeated timeouts of the same segment do not lower the slow
+     start threshold any further. */
+  if(conn->recovery != RECOVERY_RTO) {
+    conn->ssthresh = conn->cc->ssthresh(conn);
+  }
+  conn->cwnd = conn->mss;
+  conn->dupacks = 0;
+
+  /* The segments after the one that timed out were probably lost as
+     well. They are retransmitted one by one as the acknowledgments
+     come in. */
+  conn->recover = conn->len;
+  conn->recovery = RECOVERY_RTO;
+}
+/*---------------------------------------------------------------------------*/
+static void
+newreno_init(struct uip_conn *conn)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+newreno_cong_avoid(struct uip_conn *conn, u16_t acked)
+{
+  u16_t inc;
+
+  /* Grow the window by about one segment per round-trip time. */
+  inc = (unsigned long)conn->mss * acked / conn->cwnd;
+  conn->cwnd = sat_add(conn->cwnd, inc > 0? inc: 1);
+}
+/*---------------------------------------------------------------------------*/
+static u16_t
+newreno_ssthresh(struct uip_conn *conn)
+{
+  /* Half of the data in flight, but at least two segments. */
+  if(conn->len / 2 > 2 * conn->mss) {
+    return conn->len / 2;
+  }
+  return 2 * conn->mss;
+}
+/*---------------------------------------------------------------------------*/
+const struct uip_cc uip_cc_newreno = {
+  newreno_init,
+  newreno_cong_avoid,
+  newreno_ssthresh
+};
+/*---------------------------------------------------------------------------*/
+/* CUBIC keeps its time in 1/64 seconds, and uses the private state of
+   the connection for the window size before the last loss (W_max),
+   the origin of the cubic function, the time from the start of the
+   epoch to the origin (K), the start of the epoch, and the estimated
+   window of a NewReno flow in the same situation. */
+#define CUBIC_HZ 64
+
+#define W_MAX(conn)  (conn)->ccstate[0]
+#define ORIGIN(conn) (conn)->ccstate[1]
+#define K(conn)      (conn)->ccstate[2]
+#define EPOCH(conn)  (conn)->ccstate[3]
+#define W_EST(conn)  (conn)->ccstate[4]
+
+static u16_t
+cubic_time(void)
+{
+  return (unsigned long)clock_time() * CUBIC_HZ / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+icbrt(unsigned long x)
+{
+  unsigned long y, b;
+  int s;
+
+  /* Integer cube root, one bit at a time. */
+  y = 0;
+  for(s = 30; s >= 0; s -= 3) {
+    y <<= 1;
+    b = (3 * y * (y + 1) + 1) << s;
+    if(x >= b) {
+      x -= b;
+      ++y;
+    }
+  }
+  return y;
+}
+/*---------------------------------------------------------------------------*/
+static void
+cubic_init(struct uip_conn *conn)
+{
+  W_MAX(conn) = ORIGIN(conn) = K(conn) = EPOCH(conn) = W_EST(conn) = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+cubic_cong_avoid(struct uip_conn *conn, u16_t acked)
+{
+  u16_t t, target;
+  unsigned long d, inc;
+
+  if(ORIGIN(conn) == 0) {
+    /* A new congestion avoidance epoch starts. The window grows
+       towards W_max along a cubic curve that reaches W_max after K
+       seconds, where K = cbrt(W_max * (1 - beta) / C) with C = 0.4,
+       and W_max - cwnd is the reduction. */
+    EPOCH(conn) = cubic_time();
+    W_EST(conn) = conn->cwnd;
+    if(conn->cwnd < W_MAX(conn)) {
+      d = ((unsigned long)(W_MAX(conn) - conn->cwnd) << 4) / conn->mss;
+      if(d > 100000) {
+	d = 100000;
+      }
+      /* 64^3 * 2.5 / 16 = 40960. */
+      K(conn) = icbrt(d * 40960);
+      ORIGIN(conn) = W_MAX(conn);
+    } else {
+      K(conn) = 0;
+      ORIGIN(conn) = conn->cwnd;
+    }
+  }
+
+  /* Compute the target window C * (t - K)^3 + W_max, in bytes. */
+  t = cubic_time() - EPOCH(conn);
+  d = t > K(conn)? t - K(conn): K(conn) - t;
+  if(d > 1023) {
+    d = 1023;
+  }
+  d = (d * d * d) >> 8;
+  d = d * 2 / 5;
+  d = ((d >> 5) * conn->mss) >> 5;
+  if(d > 0xffff) {
+    d = 0xffff;
+  }
+  if(t > K(conn)) {
+    target = sat_add(ORIGIN(conn), d);
+  } else {
+    target = ORIGIN(conn) > d + conn->mss? ORIGIN(conn) - d: conn->mss;
+  }
+
+  /* The TCP-friendly region: the window never grows slower than that
+     of a NewReno flow, which grows by 3 * (1 - beta) / (1 + beta) =
+     9 / 17 segments per round-trip time with the same beta. On links
+     with a short round-trip time, this is what drives the growth. */
+  W_EST(conn) = sat_add(W_EST(conn),
+			(unsigned long)conn->mss * acked * 9 /
+			(17UL * conn->cwnd));
+  if(W_EST(conn) > target) {
+    target = W_EST(conn);
+  }
+
+  /* Move the window towards the target, but never by more than half
+     of the data that was acknowledged. Close to W_max the window
+     grows very slowly. */
+  if(target > conn->cwnd) {
+    inc = (unsigned long)(target - conn->cwnd) * acked / conn->cwnd;
+  } else {
+    inc = (unsigned long)conn->mss * acked / (100UL * conn->cwnd);
+  }
+  if(inc > acked / 2) {
+    inc = acked / 2;
+  }
+  conn->cwnd = sat_add(conn->cwnd, inc);
+}
+/*---------------------------------------------------------------------------*/
+static u16_t
+cubic_ssthresh(struct uip_conn *conn)
+{
+  unsigned long ssthresh;
+
+  /* Fast convergence: if the window did not reach the previous
+     W_max, the available bandwidth is likely to have decreased, and
+     we let go of some of it to other flows. */
+  if(conn->cwnd < W_MAX(conn)) {
+    W_MAX(conn) = (unsigned long)conn->cwnd * 17 / 20;
+  } else {
+    W_MAX(conn) = conn->cwnd;
+  }
+  ORIGIN(conn) = 0;
+
+  /* Multiplicative decrease with beta = 0.7. */
+  ssthresh = (unsigned long)conn->cwnd * 7 / 10;
+  if(ssthresh < 2 * conn->mss) {
+    ssthresh = 2 * conn->mss;
+  }
+  return ssthresh;
+}
+/*---------------------------------------------------------------------------*/
+const struct uip_cc uip_cc_cubic = {
+  cubic_init,
+  cubic_cong_avoid,
+  cubic_ssthresh
+};
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_TCP_CC */
+
+/** @} */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+/**
+ * \defgroup uipcc uIP TCP congestion control
+ * @{
+ *
+ * When more than one TCP segment may be in flight on a connection
+ * (UIP_TCP_WINDOW_SEGMENTS > 1), uIP can use TCP congestion control
+ * (UIP_TCP_CC) to limit the amount of data in flight to what the
+ * network can take. The module implements slow start, fast
+ * retransmit after three duplicate acknowledgments and NewReno fast
+ * recovery (RFC 5681, RFC 6582).
+ *
+ * The congestion avoidance algorithm, which decides how the
+ * congestion window grows when there is no loss and how much it
+ * shrinks after a loss, is pluggable. Each algorithm is described by
+ * a struct uip_cc that is referenced by the connection. The NewReno
+ * (uip_cc_newreno) and CUBIC (uip_cc_cubic) algorithms are provided.
+ */
+
+/**
+ * \file
+ * TCP congestion control.
+ */
+
+#ifndef __UIP_CC_H__
+#define __UIP_CC_H__
+
+#include "uip.h"
+
+#if UIP_TCP_CC && UIP_TCP_WINDOW_SEGMENTS < 2
+#error "UIP_CONF_TCP_CC requires UIP_CONF_TCP_WINDOW_SEGMENTS > 1"
+#endif
+
+/**
+ * A congestion avoidance algorithm.
+ */
+struct uip_cc {
+  /** Sets up the private state of the algorithm for a new
+      connection. */
+  void (* init)(struct uip_conn *conn);
+  /** Grows the congestion window after acked bytes have been
+      acknowledged outside of slow start. */
+  void (* cong_avoid)(struct uip_conn *conn, u16_t acked);
+  /** Returns the new slow start threshold after a loss. */
+  u16_t (* ssthresh)(struct uip_conn *conn);
+};
+
+/** The NewReno congestion avoidance algorithm (RFC 5681). */
+extern const struct uip_cc uip_cc_newreno;
+/** The CUBIC congestion avoidance algorithm (RFC 8312). */
+extern const struct uip_cc uip_cc_cubic;
+
+/**
+ * Set the congestion avoidance algorithm of the current connection.
+ *
+ * This should be done when the application is called with
+ * uip_connected() set, before any data is sent.
+ *
+ * \param alg A pointer to the struct uip_cc of the algorithm.
+ *
+ * \hideinitializer
+ */
+#define uip_cc_set(alg) do { uip_conn->cc = (alg);	\
+			     (alg)->init(uip_conn); } while(0)
+
+/**
+ * \internal
+ * Set up the congestion control state of a connection that has just
+ * been established.
+ */
+void uip_cc_init(struct uip_conn *conn);
+
+/**
+ * \internal
+ * Update the congestion control state after acked bytes of data
+ * have been acknowledged.
+ *
+ * \return Non-zero if the oldest segment in flight should be
+ * retransmitted right away.
+ */
+u8_t uip_cc_ack(struct uip_conn *conn, u16_t acked);
+
+/**
+ * \internal
+ * Update the congestion control state after a duplicate
+ * acknowledgment has been received.
+ *
+ * \return Non-zero if the oldest segment in flight should be
+ * retransmitted right away.
+ */
+u8_t uip_cc_dupack(struct uip_conn *conn);
+
+/**
+ * \internal
+ * Update the congestion control state after the retransmission timer
+ * has expired.
+ */
+void uip_cc_timeout(struct uip_conn *conn);
+
+#endif /* __UIP_CC_H__ */
+
+/** @} */
+/** @} */
@@ -459,15 +459,13 @@ uip_fw_forward(void)
     time_exceeded();
   }
   
-  /* Decrement the TTL (time-to-live) value in the IP header */
+  /* Update the IP checksum for the TTL (time-to-live) value, which
+     shares a 16-bit word with the protocol field, and decrement the
+     TTL in the IP header. */
+  BUF->ipchksum = uip_chksum_update16(BUF->ipchksum,
+				      (BUF->ttl << 8) | BUF->proto,
+				      ((BUF->ttl - 1) << 8) | BUF->proto);
   BUF->ttl = BUF->ttl - 1;
-  
-  /* Update the IP checksum. */
-  if(BUF->ipchksum >= HTONS(0xffff - 0x0100)) {
-    BUF->ipchksum = BUF->ipchksum + HTONS(0x0100) + 1;
-  } else {
-    BUF->ipchksum = BUF->ipchksum + HTONS(0x0100);
-  }
 
   if(uip_len > 0) {
     uip_appdata = &uip_buf[UIP_LLH_LEN + UIP_TCPIP_HLEN];
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+/**
+ * \addtogroup uippacket
+ * @{
+ */
+
+/**
+ * \file
+ * Packet buffer pool.
+ */
+
+#include "uip-packet.h"
+#include "memb.h"
+
+#include <string.h> /* for NULL */
+
+#if UIP_PACKETS
+
+MEMB(packets, struct uip_packet, UIP_PACKETS);
+
+static u8_t avail;
+
+struct uip_packet *uip_packet;
+u8_t *uip_buf;
+
+/*---------------------------------------------------------------------------*/
+void
+uip_packet_init(void)
+{
+  memb_init(&packets);
+  avail = UIP_PACKETS;
+  uip_packet_select(uip_packet_alloc());
+}
+/*---------------------------------------------------------------------------*/
+struct uip_packet *
+uip_packet_alloc(void)
+{
+  struct uip_packet *p;
+
+  p = memb_alloc(&packets);
+  if(p != NULL) {
+    --avail;
+    p->len = 0;
+    p->next = NULL;
+#if UIP_ZEROCOPY
+    p->reflen = 0;
+#endif /* UIP_ZEROCOPY */
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_packet_free(struct uip_packet *p)
+{
+  if(memb_free(&packets, p) == 0) {
+    ++avail;
+  }
+}
+/*---------------------------------------------------------------------------*/
+u8_t
+uip_packet_avail(void)
+{
+  return avail;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_packet_select(struct uip_packet *p)
+{
+  uip_packet = p;
+  uip_buf = p->buf;
+  uip_len = p->len;
+#if UIP_ZEROCOPY
+  uip_reflen = p->reflen;
+  if(p->reflen > 0) {
+    uip_appdata = p->appdata;
+  }
+#endif /* UIP_ZEROCOPY */
+}
+/*---------------------------------------------------------------------------*/
+struct uip_packet *
+uip_packet_detach(void)
+{
+  struct uip_packet *p, *newp;
+
+  newp = uip_packet_alloc();
+  if(newp == NULL) {
+    return NULL;
+  }
+  p = uip_packet;
+  p->len = uip_len;
+#if UIP_ZEROCOPY
+  p->appdata = uip_appdata;
+  p->reflen = uip_reflen;
+#endif /* UIP_ZEROCOPY */
+  uip_packet_select(newp);
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_packet_enqueue(struct uip_packet_queue *q, struct uip_packet *p)
+{
+  p->next = NULL;
+  if(q->head == NULL) {
+    q->head = p;
+  } else {
+    q->tail->next = p;
+  }
+  q->tail = p;
+}
+/*---------------------------------------------------------------------------*/
+struct uip_packet *
+uip_packet_dequeue(struct uip_packet_queue *q)
+{
+  struct uip_packet *p;
+
+  p = q->head;
+  if(p != NULL) {
+    q->head = p->next;
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif /* UIP_PACKETS */
+
+/** @} */
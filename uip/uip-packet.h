@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+/**
+ * \defgroup uippacket uIP packet buffer pool
+ * @{
+ *
+ * Normally, uIP has a single packet buffer, uip_buf, which means
+ * that the device driver must process and transmit every incoming
+ * packet before it reads the next one. With the packet buffer pool
+ * (UIP_PACKETS > 0), uip_buf instead points to the buffer of the
+ * current packet, which is one of a fixed number of packet buffers.
+ *
+ * The device driver can read a batch of packets by reading each
+ * packet into uip_buf as usual and detaching it from uip_buf with
+ * uip_packet_detach(), which puts a fresh buffer in its place. The
+ * packets are then processed one at a time by selecting them with
+ * uip_packet_select() and calling uip_input(). Outbound packets can
+ * be detached and queued in the same way, and be transmitted later.
+ *
+ * Code that only uses uip_buf and uip_len works as before, since
+ * there always is a current packet.
+ */
+
+/**
+ * \file
+ * Packet buffer pool.
+ */
+
+#ifndef __UIP_PACKET_H__
+#define __UIP_PACKET_H__
+
+#include "uip.h"
+
+/**
+ * A packet buffer.
+ */
+struct uip_packet {
+  u8_t buf[UIP_BUFSIZE + 2]; /**< The packet data. */
+  u16_t len;                 /**< The length of the packet, while it is
+				not the current packet. */
+  struct uip_packet *next;   /**< Pointer to the next packet in a
+				queue. */
+#if UIP_ZEROCOPY
+  void *appdata;             /**< The data of the packet that is not
+				in the buffer, if reflen > 0. */
+  u16_t reflen;              /**< The length of that data. */
+#endif /* UIP_ZEROCOPY */
+};
+
+/**
+ * A queue of packet buffers.
+ */
+struct uip_packet_queue {
+  struct uip_packet *head, *tail;
+};
+
+/**
+ * Pointer to the current packet, whose buffer uip_buf points to.
+ */
+extern struct uip_packet *uip_packet;
+
+/**
+ * Initialize the packet buffer pool.
+ *
+ * This function is called by uip_init().
+ */
+void uip_packet_init(void);
+
+/**
+ * Allocate a packet buffer from the pool.
+ *
+ * \return A pointer to an empty packet buffer, or NULL if all packet
+ * buffers are in use.
+ */
+struct uip_packet *uip_packet_alloc(void);
+
+/**
+ * Return a packet buffer to the pool.
+ *
+ * \param p A pointer to the packet buffer. It must not be the current
+ * packet.
+ */
+void uip_packet_free(struct uip_packet *p);
+
+/**
+ * Get the number of free packet buffers in the pool.
+ */
+u8_t uip_packet_avail(void);
+
+/**
+ * Make a packet the current packet.
+ *
+ * This function points uip_buf to the buffer of the packet and sets
+ * uip_len to its length. The previous current packet is not freed,
+ * so the caller must keep track of it.
+ *
+ * \param p A pointer to the packet buffer.
+ */
+void uip_packet_select(struct uip_packet *p);
+
+/**
+ * Detach the current packet from uip_buf.
+ *
+ * This function saves uip_len as the length of the current packet,
+ * and makes a newly allocated, empty packet buffer the current
+ * packet.
+ *
+ * \return A pointer to the packet that was the current packet, or
+ * NULL if there was no free packet buffer in the pool, in which case
+ * the current packet is left as it is.
+ */
+struct uip_packet *uip_packet_detach(void);
+
+/**
+ * Add a packet to the end of a queue.
+ *
+ * \param q A pointer to the queue.
+ *
+ * \param p A pointer to the packet buffer.
+ */
+void uip_packet_enqueue(struct uip_packet_queue *q, struct uip_packet *p);
+
+/**
+ * Remove the packet at the head of a queue.
+ *
+ * \param q A pointer to the queue.
+ *
+ * \return A pointer to the packet buffer, or NULL if the queue is
+ * empty.
+ */
+struct uip_packet *uip_packet_dequeue(struct uip_packet_queue *q);
+
+#endif /* __UIP_PACKET_H__ */
+
+/** @} */
+/** @} */
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+/**
+ * \addtogroup uipsendbuf
+ * @{
+ */
+
+/**
+ * \file
+ * TCP send buffers.
+ */
+
+#include "uip-sendbuf.h"
+#include "memb.h"
+
+#include <string.h>
+
+#if UIP_TCP_SENDBUFS
+
+MEMB(sendbufs, struct uip_sendbuf, UIP_TCP_SENDBUFS);
+
+/*---------------------------------------------------------------------------*/
+/*
+ * Drop the data that the remote host has acknowledged. Everything
+ * that has been sent but is no longer outstanding on the connection
+ * has been acknowledged.
+ */
+static void
+acked(struct uip_sendbuf *sb, struct uip_conn *conn)
+{
+  u16_t n;
+
+  if(sb->sent > conn->len) {
+    n = sb->sent - conn->len;
+    sb->start += n;
+    if(sb->start >= UIP_TCP_SENDBUF_SIZE) {
+      sb->start -= UIP_TCP_SENDBUF_SIZE;
+    }
+    sb->len -= n;
+    sb->sent = conn->len;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+copy_out(struct uip_sendbuf *sb, u8_t *dst, u16_t off, u16_t len)
+{
+  u16_t n;
+
+  off += sb->start;
+  if(off >= UIP_TCP_SENDBUF_SIZE) {
+    off -= UIP_TCP_SENDBUF_SIZE;
+  }
+  n = UIP_TCP_SENDBUF_SIZE - off;
+  if(n > len) {
+    n = len;
+  }
+  memcpy(dst, &sb->buf[off], n);
+  memcpy(dst + n, sb->buf, len - n);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_sendbuf_init(void)
+{
+  memb_init(&sendbufs);
+}
+/*---------------------------------------------------------------------------*/
+u8_t
+uip_sendbuf_alloc(void)
+{
+  struct uip_sendbuf *sb;
+
+  if(uip_conn->sendbuf == NULL) {
+    sb = memb_alloc(&sendbufs);
+    if(sb == NULL) {
+      return 0;
+    }
+    sb->start = sb->len = sb->sent = 0;
+    sb->closing = 0;
+    uip_conn->sendbuf = sb;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_sendbuf_free(struct uip_conn *conn)
+{
+  memb_free(&sendbufs, conn->sendbuf);
+  conn->sendbuf = NULL;
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_sendbuf_room(void)
+{
+  struct uip_sendbuf *sb;
+
+  sb = uip_conn->sendbuf;
+  acked(sb, uip_conn);
+  return UIP_TCP_SENDBUF_SIZE - sb->len;
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_sendbuf_write(const void *data, u16_t len)
+{
+  struct uip_sendbuf *sb;
+  u16_t end, n;
+
+  sb = uip_conn->sendbuf;
+  acked(sb, uip_conn);
+  if(len > UIP_TCP_SENDBUF_SIZE - sb->len) {
+    len = UIP_TCP_SENDBUF_SIZE - sb->len;
+  }
+
+  end = sb->start + sb->len;
+  if(end >= UIP_TCP_SENDBUF_SIZE) {
+    end -= UIP_TCP_SENDBUF_SIZE;
+  }
+  n = UIP_TCP_SENDBUF_SIZE - end;
+  if(n > len) {
+    n = len;
+  }
+  memcpy(&sb->buf[end], data, n);
+  memcpy(sb->buf, (const u8_t *)data + n, len - n);
+  sb->len += len;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_sendbuf_output(struct uip_conn *conn, void *dst)
+{
+  struct uip_sendbuf *sb;
+  u16_t n, room;
+
+  sb = conn->sendbuf;
+  acked(sb, conn);
+
+  /* The FIN goes out after the last byte in the buffer has been
+     acknowledged. */
+  if(uip_flags & UIP_CLOSE) {
+    if(sb->len > 0) {
+      sb->closing = 1;
+      uip_flags &= ~UIP_CLOSE;
+    }
+  } else if(sb->closing && sb->len == 0) {
+    uip_flags |= UIP_CLOSE;
+  }
+  if(uip_flags & UIP_CLOSE) {
+    uip_sendbuf_free(conn);
+    return 0;
+  }
+
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+  room = uip_sendroom(conn);
+#else /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+  room = conn->len == 0? conn->mss: 0;
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+  n = sb->len - sb->sent;
+  if(n > room) {
+    n = room;
+  }
+  copy_out(sb, dst, sb->sent, n);
+  sb->sent += n;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_sendbuf_rexmit(struct uip_conn *conn, void *dst)
+{
+  struct uip_sendbuf *sb;
+
+  sb = conn->sendbuf;
+  acked(sb, conn);
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+  copy_out(sb, dst, uip_rexmit_off, uip_rexmit_len);
+  return uip_rexmit_len;
+#else /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+  copy_out(sb, dst, 0, conn->len);
+  return conn->len;
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+}
+/*---------------------------------------------------------------------------*/
+
+#endif /* UIP_TCP_SENDBUFS */
+
+/** @} */
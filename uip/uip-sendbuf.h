@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+/**
+ * \defgroup uipsendbuf uIP TCP send buffers
+ * @{
+ *
+ * Normally, uIP does not keep the data it sends, so an application
+ * hands uIP at most one segment at a time, waits for it to be
+ * acknowledged, and is called upon to produce the same data again if
+ * it has to be retransmitted. With send buffers (UIP_TCP_SENDBUFS >
+ * 0), an application can instead give a connection a ring buffer with
+ * uip_sendbuf_alloc() and write data into it with
+ * uip_sendbuf_write(). uIP sends the data as the window of the remote
+ * host allows, retransmits it from the buffer, and drops it once it
+ * has been acknowledged, so the application only has to wait when the
+ * buffer is full.
+ *
+ * A connection with a send buffer must only send data through the
+ * buffer, and the application need not handle uip_rexmit(). When the
+ * application calls uip_close(), the connection is closed once all
+ * data in the buffer has been acknowledged; the application can be
+ * called with uip_acked() and uip_poll() until then. The buffer is
+ * returned to the pool when the connection is closed.
+ *
+ * The buffers are taken from a pool of UIP_TCP_SENDBUFS buffers of
+ * UIP_TCP_SENDBUF_SIZE bytes each.
+ */
+
+/**
+ * \file
+ * TCP send buffers.
+ */
+
+#ifndef __UIP_SENDBUF_H__
+#define __UIP_SENDBUF_H__
+
+#include "uip.h"
+
+/**
+ * A send buffer.
+ */
+struct uip_sendbuf {
+  u16_t start;    /**< The offset of the oldest data in the buffer. */
+  u16_t len;      /**< The number of bytes in the buffer. */
+  u16_t sent;     /**< The number of bytes at the start of the buffer
+		     that have been sent. */
+  u8_t closing;   /**< Non-zero if the connection is to be closed once
+		     the buffer is empty. */
+  u8_t buf[UIP_TCP_SENDBUF_SIZE]; /**< The data. */
+};
+
+/**
+ * Initialize the send buffer pool.
+ *
+ * This function is called by uip_init().
+ */
+void uip_sendbuf_init(void);
+
+/**
+ * Give the current connection a send buffer.
+ *
+ * This function should be called when the application is called
+ * with uip_connected() true, before any data is sent on the
+ * connection.
+ *
+ * \return Non-zero if the connection has a send buffer, or zero if
+ * all send buffers are in use, in which case the application must
+ * send its data with uip_send() as usual.
+ */
+u8_t uip_sendbuf_alloc(void);
+
+/**
+ * Check if the current connection has a send buffer.
+ *
+ * \hideinitializer
+ */
+#define uip_sendbuf_used() (uip_conn->sendbuf != NULL)
+
+/**
+ * Get the number of bytes that can be written to the send buffer of
+ * the current connection.
+ */
+u16_t uip_sendbuf_room(void);
+
+/**
+ * Write data to the send buffer of the current connection.
+ *
+ * The data is copied to the buffer, and is sent by uIP when the
+ * application returns and whenever the window of the remote host
+ * allows later on.
+ *
+ * \param data A pointer to the data.
+ *
+ * \param len The length of the data.
+ *
+ * \return The number of bytes written, which is less than len if
+ * the buffer is full.
+ */
+u16_t uip_sendbuf_write(const void *data, u16_t len);
+
+/**
+ * Put the next segment of buffered data into an outgoing packet.
+ *
+ * This function is called by uip_process() after the application of
+ * a connection with a send buffer has been called. It also holds
+ * back a close request until the buffer is empty.
+ *
+ * \param conn A pointer to the connection.
+ *
+ * \param dst A pointer to where the data of the packet goes.
+ *
+ * \return The length of the data.
+ */
+u16_t uip_sendbuf_output(struct uip_conn *conn, void *dst);
+
+/**
+ * Put buffered data that is to be retransmitted into an outgoing
+ * packet.
+ *
+ * This function is called by uip_process() instead of letting the
+ * application retransmit data.
+ *
+ * \param conn A pointer to the connection.
+ *
+ * \param dst A pointer to where the data of the packet goes.
+ *
+ * \return The length of the data.
+ */
+u16_t uip_sendbuf_rexmit(struct uip_conn *conn, void *dst);
+
+/**
+ * Return the send buffer of a connection to the pool.
+ *
+ * \param conn A pointer to the connection.
+ */
+void uip_sendbuf_free(struct uip_conn *conn);
+
+#endif /* __UIP_SENDBUF_H__ */
+
+/** @} */
+/** @} */
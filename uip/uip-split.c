@@ -44,45 +44,62 @@
 
 #define BUF ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
 
+/*-----------------------------------------------------------------------------*/
+static void
+set_len(void)
+{
+#if UIP_CONF_IPV6
+  /* For IPv6, the IP length field does not include the IPv6 IP header
+     length. */
+  BUF->len[0] = ((uip_len - UIP_IPH_LEN) >> 8);
+  BUF->len[1] = ((uip_len - UIP_IPH_LEN) & 0xff);
+#else /* UIP_CONF_IPV6 */
+  BUF->len[0] = uip_len >> 8;
+  BUF->len[1] = uip_len & 0xff;
+#endif /* UIP_CONF_IPV6 */
+}
 /*-----------------------------------------------------------------------------*/
 void
 uip_split_output(void)
 {
-  u16_t tcplen, len1, len2;
+  u16_t tcplen, len1, len2, sum2;
+#if UIP_ZEROCOPY
+  u16_t reflen;
+#endif /* UIP_ZEROCOPY */
 
   /* We only try to split maximum sized TCP segments. */
   if(BUF->proto == UIP_PROTO_TCP &&
      uip_len == UIP_BUFSIZE - UIP_LLH_LEN) {
 
     tcplen = uip_len - UIP_TCPIP_HLEN;
-    /* Split the segment in two. If the original packet length was
-       odd, we make the second packet one byte larger. */
-    len1 = len2 = tcplen / 2;
-    if(len1 + len2 < tcplen) {
-      ++len2;
-    }
+    /* Split the segment in two. The first packet gets an even length,
+       so the data of the second packet starts at an even offset in
+       both packets and only needs to be summed once. */
+    len1 = (tcplen / 2) & ~1;
+    len2 = tcplen - len1;
+    sum2 = htons(uip_chksum((u16_t *)((u8_t *)uip_appdata + len1), len2));
 
     /* Create the first packet. This is done by altering the length
-       field of the IP header and updating the checksums. */
+       field of the IP header and updating the checksums for the new
+       length and for the data of the second packet, which is cut
+       off. */
     uip_len = len1 + UIP_TCPIP_HLEN;
-#if UIP_CONF_IPV6
-    /* For IPv6, the IP length field does not include the IPv6 IP header
-       length. */
-    BUF->len[0] = ((uip_len - UIP_IPH_LEN) >> 8);
-    BUF->len[1] = ((uip_len - UIP_IPH_LEN) & 0xff);
-#else /* UIP_CONF_IPV6 */
-    BUF->len[0] = uip_len >> 8;
-    BUF->len[1] = uip_len & 0xff;
-#endif /* UIP_CONF_IPV6 */
-    
-    /* Recalculate the TCP checksum. */
-    BUF->tcpchksum = 0;
-    BUF->tcpchksum = ~(uip_tcpchksum());
+    set_len();
+#if UIP_ZEROCOPY
+    reflen = uip_reflen;
+    if(reflen > 0) {
+      uip_reflen = len1;
+    }
+#endif /* UIP_ZEROCOPY */
+
+    BUF->tcpchksum = uip_chksum_update16(BUF->tcpchksum,
+					 tcplen + UIP_TCPH_LEN,
+					 len1 + UIP_TCPH_LEN);
+    BUF->tcpchksum = uip_chksum_update16(BUF->tcpchksum, sum2, 0);
 
 #if !UIP_CONF_IPV6
-    /* Recalculate the IP checksum. */
-    BUF->ipchksum = 0;
-    BUF->ipchksum = ~(uip_ipchksum());
+    BUF->ipchksum = uip_chksum_update16(BUF->ipchksum,
+					tcplen + UIP_TCPIP_HLEN, uip_len);
 #endif /* UIP_CONF_IPV6 */
     
     /* Transmit the first packet. */
@@ -94,34 +111,47 @@ uip_split_output(void)
        sequence number and point the uip_appdata to a new place in
        memory. This place is detemined by the length of the first
        packet (len1). */
-    uip_len = len2 + UIP_TCPIP_HLEN;
-#if UIP_CONF_IPV6
-    /* For IPv6, the IP length field does not include the IPv6 IP header
-       length. */
-    BUF->len[0] = ((uip_len - UIP_IPH_LEN) >> 8);
-    BUF->len[1] = ((uip_len - UIP_IPH_LEN) & 0xff);
-#else /* UIP_CONF_IPV6 */
-    BUF->len[0] = uip_len >> 8;
-    BUF->len[1] = uip_len & 0xff;
-#endif /* UIP_CONF_IPV6 */
-    
+#if UIP_ZEROCOPY
+    /* Data sent with uip_sendref() is not in uip_buf and must not be
+       moved, so the second packet just refers to the rest of it. */
+    if(reflen > 0) {
+      uip_appdata = (u8_t *)uip_appdata + len1;
+    } else {
+      memmove(uip_appdata, (u8_t *)uip_appdata + len1, len2);
+    }
+    uip_reflen = 0;
+#else /* UIP_ZEROCOPY */
     /*    uip_appdata += len1;*/
-    memcpy(uip_appdata, (u8_t *)uip_appdata + len1, len2);
+    memmove(uip_appdata, (u8_t *)uip_appdata + len1, len2);
+#endif /* UIP_ZEROCOPY */
 
     uip_add32(BUF->seqno, len1);
     BUF->seqno[0] = uip_acc32[0];
     BUF->seqno[1] = uip_acc32[1];
     BUF->seqno[2] = uip_acc32[2];
     BUF->seqno[3] = uip_acc32[3];
-    
-    /* Recalculate the TCP checksum. */
+
+    /* The TCP checksum is calculated over the headers only, and the
+       length and the already summed data are then added to it. */
+    uip_len = UIP_TCPIP_HLEN;
+    set_len();
     BUF->tcpchksum = 0;
     BUF->tcpchksum = ~(uip_tcpchksum());
+    BUF->tcpchksum = uip_chksum_update16(BUF->tcpchksum, UIP_TCPH_LEN,
+					 len2 + UIP_TCPH_LEN);
+    BUF->tcpchksum = uip_chksum_update16(BUF->tcpchksum, 0, sum2);
+
+    uip_len = len2 + UIP_TCPIP_HLEN;
+    set_len();
+#if UIP_ZEROCOPY
+    if(reflen > 0) {
+      uip_reflen = len2;
+    }
+#endif /* UIP_ZEROCOPY */
 
 #if !UIP_CONF_IPV6
-    /* Recalculate the IP checksum. */
-    BUF->ipchksum = 0;
-    BUF->ipchksum = ~(uip_ipchksum());
+    BUF->ipchksum = uip_chksum_update16(BUF->ipchksum,
+					len1 + UIP_TCPIP_HLEN, uip_len);
 #endif /* UIP_CONF_IPV6 */
 
     /* Transmit the second packet. */
@@ -87,7 +87,42 @@
 #include "uip-neighbor.h"
 #endif /* UIP_CONF_IPV6 */
 
+#if UIP_TCP_CC
+#include "uip-cc.h"
+#endif /* UIP_TCP_CC */
+
+#if UIP_PACKETS
+#include "uip-packet.h"
+#endif /* UIP_PACKETS */
+
+#if UIP_TCP_SENDBUFS
+#include "uip-sendbuf.h"
+#endif /* UIP_TCP_SENDBUFS */
+
+#if UIP_TCP_REORDER && !UIP_PACKETS
+#error "UIP_CONF_TCP_REORDER requires UIP_CONF_PACKETS"
+#endif /* UIP_TCP_REORDER && !UIP_PACKETS */
+
+#if UIP_TCP_DELAYED_ACK && !UIP_TCP_CLOCK_RTO
+#error "UIP_CONF_TCP_DELAYED_ACK requires UIP_CONF_TCP_CLOCK_RTO"
+#endif /* UIP_TCP_DELAYED_ACK && !UIP_TCP_CLOCK_RTO */
+
+#if UIP_TCP_SYNCOOKIES && !UIP_TCP_CLOCK_RTO
+#error "UIP_CONF_TCP_SYNCOOKIES requires UIP_CONF_TCP_CLOCK_RTO"
+#endif /* UIP_TCP_SYNCOOKIES && !UIP_TCP_CLOCK_RTO */
+
+#if UIP_TCP_SACK && !UIP_TCP_REORDER
+#error "UIP_CONF_TCP_SACK requires UIP_CONF_TCP_REORDER"
+#endif /* UIP_TCP_SACK && !UIP_TCP_REORDER */
+
+#if UIP_TCP_SACK && UIP_TCP_CC && UIP_TCP_WINDOW_SEGMENTS > 16
+#error "UIP_CONF_TCP_SACK supports at most 16 UIP_CONF_TCP_WINDOW_SEGMENTS"
+#endif /* UIP_TCP_SACK && UIP_TCP_CC && UIP_TCP_WINDOW_SEGMENTS > 16 */
+
 #include <string.h>
+#if UIP_DYNAMIC_TABLES
+#include <stdlib.h>
+#endif /* UIP_DYNAMIC_TABLES */
 
 /*---------------------------------------------------------------------------*/
 /* Variable definitions. */
@@ -135,7 +170,7 @@ const struct uip_eth_addr uip_ethaddr = {{UIP_ETHADDR0,
 struct uip_eth_addr uip_ethaddr = {{0,0,0,0,0,0}};
 #endif
 
-#ifndef UIP_CONF_EXTERNAL_BUFFER
+#if !defined(UIP_CONF_EXTERNAL_BUFFER) && !UIP_PACKETS
 u8_t uip_buf[UIP_BUFSIZE + 2];   /* The packet buffer that contains
 				    incoming packets. */
 #endif /* UIP_CONF_EXTERNAL_BUFFER */
@@ -145,6 +180,16 @@ void *uip_appdata;               /* The uip_appdata pointer points to
 void *uip_sappdata;              /* The uip_appdata pointer points to
 				    the application data which is to
 				    be sent. */
+#if UIP_ZEROCOPY
+u16_t uip_reflen;                /* The length of the data at the end
+				    of the outgoing packet that is
+				    not in uip_buf. */
+static const void *sendref;      /* The data passed to
+				    uip_sendref(), or NULL. */
+u16_t uip_refsum, uip_refsumlen; /* The sum of the data passed to
+				    uip_sendrefsum(), and its
+				    length. */
+#endif /* UIP_ZEROCOPY */
 #if UIP_URGDATA > 0
 void *uip_urgdata;               /* The uip_urgdata pointer points to
    				    urgent data (out-of-band data), if
@@ -152,6 +197,18 @@ void *uip_urgdata;               /* The uip_urgdata pointer points to
 u16_t uip_urglen, uip_surglen;
 #endif /* UIP_URGDATA > 0 */
 
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+u16_t uip_acklen;            /* The number of bytes acknowledged by
+				the incoming segment. */
+u16_t uip_rexmit_off, uip_rexmit_len;
+			     /* The part of the unacknowledged data
+				that the application should
+				retransmit. */
+static u16_t sndoff;         /* The offset from snd_nxt of the
+				sequence number of the outgoing
+				segment. */
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+
 u16_t uip_len, uip_slen;
                              /* The uip_len is either 8 or 16 bits,
 				depending on the maximum packet
@@ -163,30 +220,152 @@ u8_t uip_flags;     /* The uip_flags variable is used for
 struct uip_conn *uip_conn;   /* uip_conn always points to the current
 				connection. */
 
+#if UIP_DYNAMIC_TABLES
+struct uip_conn *uip_conns;
+u16_t *uip_listenports;
+u16_t uip_conns_used, uip_listenports_used;
+static u16_t conns_max, listenports_max;
+			     /* The sizes that the tables were
+				allocated with. */
+#else /* UIP_DYNAMIC_TABLES */
 struct uip_conn uip_conns[UIP_CONNS];
                              /* The uip_conns array holds all TCP
 				connections. */
 u16_t uip_listenports[UIP_LISTENPORTS];
                              /* The uip_listenports list all currently
 				listning ports. */
+#endif /* UIP_DYNAMIC_TABLES */
 #if UIP_UDP
 struct uip_udp_conn *uip_udp_conn;
+#if UIP_DYNAMIC_TABLES
+struct uip_udp_conn *uip_udp_conns;
+u8_t uip_udp_conns_used;
+static u8_t udp_conns_max;
+#else /* UIP_DYNAMIC_TABLES */
 struct uip_udp_conn uip_udp_conns[UIP_UDP_CONNS];
+#endif /* UIP_DYNAMIC_TABLES */
 #endif /* UIP_UDP */
 
+#if UIP_TCP_HASH
+static struct uip_conn *conn_hash[UIP_TCP_HASH_SIZE];
+			     /* All connections that are not CLOSED,
+				hashed on their local port, remote port
+				and remote IP address and chained
+				through their ->hnext pointer. */
+static u16_t listen_hash[UIP_LISTEN_HASH_SIZE];
+#if UIP_DYNAMIC_TABLES
+static u16_t *listen_next;
+#else /* UIP_DYNAMIC_TABLES */
+static u16_t listen_next[UIP_LISTENPORTS];
+#endif /* UIP_DYNAMIC_TABLES */
+			     /* Hash chains of the uip_listenports
+				entries. The entries are stored as
+				index + 1 so that a zero ends a
+				chain. */
+#define LISTEN_HASH(port) (((port) ^ ((port) >> 8)) & \
+			   (UIP_LISTEN_HASH_SIZE - 1))
+#endif /* UIP_TCP_HASH */
+
+#if UIP_TCP_FASTPATH
+static struct uip_conn *lastconn;
+			     /* The connection that received the last
+				TCP segment. */
+#endif /* UIP_TCP_FASTPATH */
+
+#if UIP_TCP_TIMER_WHEEL
+#define WHEEL_BITS  6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK  (WHEEL_SLOTS - 1)
+#define WHEEL_DUE   (2 * WHEEL_SLOTS)
+#define WHEEL_NONE  0xff
+static struct uip_conn *wheel[2 * WHEEL_SLOTS + 1];
+			     /* The timer wheel. The first level has
+				one slot per tick for the connections
+				that are due within WHEEL_SLOTS ticks,
+				and the second level one slot per
+				WHEEL_SLOTS ticks for the connections
+				that are due later. The last slot
+				holds the connections that are due in
+				the current tick. */
+static u16_t uip_ticks;      /* The number of periodic timer ticks. */
+#endif /* UIP_TCP_TIMER_WHEEL */
+
+#if UIP_TCP_CLOCK_RTO
+#define MS_TO_CLOCK(ms) ((clock_time_t)((ms) * (long)CLOCK_SECOND / 1000))
+#define RTO_INIT MS_TO_CLOCK(1000)
+#define RTO_MIN  MS_TO_CLOCK(UIP_TCP_RTO_MIN)
+#define RTO_MAX  MS_TO_CLOCK(UIP_TCP_RTO_MAX)
+#if UIP_TCP_DELAYED_ACK
+#define ACK_DELAY MS_TO_CLOCK(UIP_TCP_DELAYED_ACK)
+#endif /* UIP_TCP_DELAYED_ACK */
+static struct timer rexmit_next;
+static u8_t rexmit_armed;
+			     /* A timer that expires no later than the
+				retransmission timers of all
+				connections. */
+#endif /* UIP_TCP_CLOCK_RTO */
+
 static u16_t ipid;           /* Ths ipid variable is an increasing
 				number that is used for the IP ID
 				field. */
 
 void uip_setipid(u16_t id) { ipid = id; }
 
+#if UIP_TCP_SYNCOOKIES
+static unsigned long cookie_secret;
+			     /* The secret that SYN cookies are keyed
+				with. */
+
+void uip_setcookiesecret(unsigned long secret) { cookie_secret = secret; }
+#endif /* UIP_TCP_SYNCOOKIES */
+
+#if UIP_TCP_SEQ32
+static u32_t iss;            /* The iss variable is used for the TCP
+				initial sequence number. */
+#else /* UIP_TCP_SEQ32 */
 static u8_t iss[4];          /* The iss variable is used for the TCP
 				initial sequence number. */
+#endif /* UIP_TCP_SEQ32 */
 
-#if UIP_ACTIVE_OPEN
+#if UIP_ACTIVE_OPEN && !UIP_EPHEMERAL_PORTS
 static u16_t lastport;       /* Keeps track of the last port used for
 				a new connection. */
-#endif /* UIP_ACTIVE_OPEN */
+#endif /* UIP_ACTIVE_OPEN && !UIP_EPHEMERAL_PORTS */
+
+#if UIP_EPHEMERAL_PORTS
+#if UIP_EPHEMERAL_PORTS > 27904
+#error "UIP_CONF_EPHEMERAL_PORTS cannot be larger than 27904"
+#endif /* UIP_EPHEMERAL_PORTS > 27904 */
+#define PORT_FIRST 4096
+static u8_t portmap[(UIP_EPHEMERAL_PORTS + 7) / 8]; /* The ephemeral
+						       ports in use. */
+static unsigned long portrand; /* The state of the port randomizer. */
+
+/* Gives the local port of a connection back to the allocator if it
+   was allocated there. Works for both TCP and UDP connections. */
+#define PORT_RELEASE(conn) do {			\
+    if((conn)->ephemeral) {			\
+      port_free((conn)->lport);			\
+      (conn)->ephemeral = 0;			\
+    }						\
+  } while(0)
+#endif /* UIP_EPHEMERAL_PORTS */
+
+#if UIP_TCP_TIME_WAIT_CONNS
+/* A connection in TIME_WAIT. Only what is needed to acknowledge late
+   segments is kept. */
+struct tw_entry {
+  uip_ipaddr_t ripaddr;
+  u16_t lport, rport;        /* The ports, or 0 if the entry is unused. */
+#if UIP_TCP_SEQ32
+  u32_t rcv_nxt, snd_nxt;
+#else /* UIP_TCP_SEQ32 */
+  u8_t rcv_nxt[4], snd_nxt[4];
+#endif /* UIP_TCP_SEQ32 */
+  u8_t timer;
+};
+static struct tw_entry tw_conns[UIP_TCP_TIME_WAIT_CONNS];
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
 
 /* Temporary variables. */
 u8_t uip_acc32[4];
@@ -205,8 +384,13 @@ static u16_t tmp16;
 #define TCP_OPT_END     0   /* End of TCP options list */
 #define TCP_OPT_NOOP    1   /* "No-operation" TCP option */
 #define TCP_OPT_MSS     2   /* Maximum segment size TCP option */
+#define TCP_OPT_WS      3   /* Window scale TCP option */
+#define TCP_OPT_SACK_PERM 4 /* SACK-permitted TCP option */
+#define TCP_OPT_SACK    5   /* SACK TCP option */
 
 #define TCP_OPT_MSS_LEN 4   /* Length of TCP MSS option. */
+#define TCP_OPT_WS_LEN  3   /* Length of TCP window scale option. */
+#define TCP_OPT_SACK_PERM_LEN 2 /* Length of TCP SACK-permitted option. */
 
 #define ICMP_ECHO_REPLY 0
 #define ICMP_ECHO       8
@@ -236,6 +420,22 @@ struct uip_stats uip_stat;
 #define UIP_STAT(s)
 #endif /* UIP_STATISTICS == 1 */
 
+#if UIP_TCP_HASH || UIP_TCP_REORDER || UIP_EPHEMERAL_PORTS || \
+    UIP_DYNAMIC_TABLES || UIP_TCP_SENDBUFS
+#define SET_CLOSED(conn) set_closed(conn)
+#else /* UIP_TCP_HASH || ... || UIP_TCP_SENDBUFS */
+#define SET_CLOSED(conn) ((conn)->tcpstateflags = UIP_CLOSED)
+#endif /* UIP_TCP_HASH || ... || UIP_TCP_SENDBUFS */
+
+/* Checks if the application should be polled for new data. */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+#define CAN_POLL(conn) (!((conn)->tcpstateflags & UIP_CLOSE_PENDING) && \
+			uip_sendroom(conn) > 0)
+#else /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+#define CAN_POLL(conn) (!uip_outstanding(conn) && \
+			((conn)->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED)
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+
 #if UIP_LOGGING == 1
 #include <stdio.h>
 void uip_log(char *msg);
@@ -274,6 +474,34 @@ uip_add32(u8_t *op32, u16_t op16)
 
 #endif /* UIP_ARCH_ADD32 */
 
+/* Sequence numbers in the TCP header are four bytes in network byte
+   order. */
+#define SEQ_GET(p) ((((unsigned long)(p)[0]) << 24) | \
+		    (((unsigned long)(p)[1]) << 16) | \
+		    (((unsigned long)(p)[2]) << 8) | (p)[3])
+#define SEQ_PUT(p, s) do { (p)[0] = (u8_t)((s) >> 24); \
+			   (p)[1] = (u8_t)((s) >> 16); \
+			   (p)[2] = (u8_t)((s) >> 8);  \
+			   (p)[3] = (u8_t)(s); } while(0)
+
+/* SEQ_EQ() compares a sequence number in the TCP header with one of
+   the sequence numbers of a connection, SEQ_LOAD() copies a header
+   field into a connection field and SEQ_STORE() does the opposite.
+   CONN_SEQ() gives the value of a connection field. */
+#if UIP_TCP_SEQ32
+#define CONN_SEQ(s)     (s)
+#define SEQ_EQ(p, s)    (SEQ_GET(p) == (s))
+#define SEQ_LOAD(s, p)  ((s) = SEQ_GET(p))
+#define SEQ_STORE(p, s) SEQ_PUT(p, s)
+#else /* UIP_TCP_SEQ32 */
+#define CONN_SEQ(s)     SEQ_GET(s)
+#define SEQ_EQ(p, s)    ((p)[0] == (s)[0] && (p)[1] == (s)[1] && \
+			 (p)[2] == (s)[2] && (p)[3] == (s)[3])
+#define SEQ_LOAD(s, p)  do { (s)[0] = (p)[0]; (s)[1] = (p)[1]; \
+			     (s)[2] = (p)[2]; (s)[3] = (p)[3]; } while(0)
+#define SEQ_STORE(p, s) SEQ_LOAD(p, s)
+#endif /* UIP_TCP_SEQ32 */
+
 #if ! UIP_ARCH_CHKSUM
 /*---------------------------------------------------------------------------*/
 static u16_t
@@ -344,9 +572,28 @@ upper_layer_chksum(u8_t proto)
   /* Sum IP source and destination addresses. */
   sum = chksum(sum, (u8_t *)&BUF->srcipaddr[0], 2 * sizeof(uip_ipaddr_t));
 
+#if UIP_ZEROCOPY
+  /* Sum TCP header and data. Data sent with uip_sendref() is summed
+     where it is; the headers have an even length, so the two parts
+     can be summed separately. */
+  sum = chksum(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+	       upper_layer_len - uip_reflen);
+  if(uip_reflen > 0) {
+    if(uip_refsumlen == uip_reflen) {
+      /* The application has supplied the sum of the data. */
+      sum += uip_refsum;
+      if(sum < uip_refsum) {
+	++sum;
+      }
+    } else {
+      sum = chksum(sum, (u8_t *)uip_appdata, uip_reflen);
+    }
+  }
+#else /* UIP_ZEROCOPY */
   /* Sum TCP header and data. */
   sum = chksum(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN],
 	       upper_layer_len);
+#endif /* UIP_ZEROCOPY */
     
   return (sum == 0) ? 0xffff : htons(sum);
 }
@@ -375,24 +622,798 @@ uip_udpchksum(void)
 #endif /* UIP_UDP_CHECKSUMS */
 #endif /* UIP_ARCH_CHKSUM */
 /*---------------------------------------------------------------------------*/
+u16_t
+uip_chksum_update16(u16_t chksum, u16_t oldval, u16_t newval)
+{
+  u16_t sum;
+
+  /* RFC1624, equation 3: HC' = ~(~HC + ~m + m'). */
+  sum = ~htons(chksum);
+  oldval = ~oldval;
+  sum += oldval;
+  if(sum < oldval) {
+    sum++;		/* carry */
+  }
+  sum += newval;
+  if(sum < newval) {
+    sum++;		/* carry */
+  }
+  return htons((u16_t)~sum);
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_chksum_update32(u16_t chksum, const u8_t *oldval, const u8_t *newval)
+{
+  chksum = uip_chksum_update16(chksum,
+			       ((u16_t)oldval[0] << 8) | oldval[1],
+			       ((u16_t)newval[0] << 8) | newval[1]);
+  return uip_chksum_update16(chksum,
+			     ((u16_t)oldval[2] << 8) | oldval[3],
+			     ((u16_t)newval[2] << 8) | newval[3]);
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_HASH
+static struct uip_conn **
+conn_bucket(u16_t lport, u16_t rport, const u8_t *ripaddr)
+{
+  u8_t i;
+  u16_t h;
+
+  h = lport ^ rport;
+  for(i = 0; i < sizeof(uip_ipaddr_t); i += 2) {
+    h ^= ((u16_t)ripaddr[i] << 8) | ripaddr[i + 1];
+  }
+  /* Fold the high byte into the low byte, since the port numbers are
+     in network byte order and the least significant bits of the
+     words may not vary much. */
+  h ^= h >> 8;
+  return &conn_hash[h & (UIP_TCP_HASH_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+static void
+conn_hash_insert(struct uip_conn *conn)
+{
+  struct uip_conn **bucket;
+
+  bucket = conn_bucket(conn->lport, conn->rport, (u8_t *)conn->ripaddr);
+  conn->hnext = *bucket;
+  *bucket = conn;
+}
+/*---------------------------------------------------------------------------*/
+static void
+conn_unhash(struct uip_conn *conn)
+{
+  struct uip_conn **bucket, *prev;
+
+  bucket = conn_bucket(conn->lport, conn->rport, (u8_t *)conn->ripaddr);
+  if(*bucket == conn) {
+    *bucket = conn->hnext;
+    return;
+  }
+  for(prev = *bucket; prev != NULL; prev = prev->hnext) {
+    if(prev->hnext == conn) {
+      prev->hnext = conn->hnext;
+      return;
+    }
+  }
+}
+#endif /* UIP_TCP_HASH */
+#if UIP_TCP_TIMER_WHEEL
+/*---------------------------------------------------------------------------*/
+static void
+wheel_unlink(struct uip_conn *conn)
+{
+  if(conn->wslot == WHEEL_NONE) {
+    return;
+  }
+  if(conn->wprev != NULL) {
+    conn->wprev->wnext = conn->wnext;
+  } else {
+    wheel[conn->wslot] = conn->wnext;
+  }
+  if(conn->wnext != NULL) {
+    conn->wnext->wprev = conn->wprev;
+  }
+  conn->wslot = WHEEL_NONE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_link(struct uip_conn *conn)
+{
+  u8_t slot;
+  u16_t d;
+
+  d = conn->due - uip_ticks;
+  if(d == 0 || d >= 0x8000) {
+    /* The slot of the current tick already has been emptied. */
+    slot = WHEEL_DUE;
+  } else if(d < WHEEL_SLOTS) {
+    slot = conn->due & WHEEL_MASK;
+  } else {
+    slot = WHEEL_SLOTS + ((conn->due >> WHEEL_BITS) & WHEEL_MASK);
+  }
+  conn->wslot = slot;
+  conn->wprev = NULL;
+  conn->wnext = wheel[slot];
+  if(conn->wnext != NULL) {
+    conn->wnext->wprev = conn;
+  }
+  wheel[slot] = conn;
+}
+/*---------------------------------------------------------------------------*/
+/* Counts the timer of the connection forward to the given tick. The
+   timer is never counted past the point where it fires, since that is
+   left to the periodic processing of the connection. */
+static void
+wheel_sync(struct uip_conn *conn, u16_t now)
+{
+  u16_t n;
+
+  n = now - conn->tick;
+  conn->tick = now;
+  if(conn->tcpstateflags == UIP_TIME_WAIT ||
+     conn->tcpstateflags == UIP_FIN_WAIT_2) {
+    if(n > UIP_TIME_WAIT_TIMEOUT - 1 - conn->timer) {
+      n = UIP_TIME_WAIT_TIMEOUT - 1 - conn->timer;
+    }
+    conn->timer += n;
+  } else if(conn->tcpstateflags != UIP_CLOSED &&
+	    uip_outstanding(conn)) {
+    if(n > conn->timer) {
+      n = conn->timer;
+    }
+    conn->timer -= n;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Moves the connection to the slot of the next tick at which its
+   timer fires or the application should be polled. */
+static void
+wheel_update(struct uip_conn *conn)
+{
+  wheel_unlink(conn);
+  if(conn->tcpstateflags == UIP_CLOSED) {
+    return;
+  }
+  if(conn->tcpstateflags == UIP_TIME_WAIT ||
+     conn->tcpstateflags == UIP_FIN_WAIT_2) {
+    conn->due = conn->tick + UIP_TIME_WAIT_TIMEOUT - conn->timer;
+#if !UIP_TCP_CLOCK_RTO
+  } else if(uip_outstanding(conn) && !CAN_POLL(conn)) {
+    conn->due = conn->tick + conn->timer + 1;
+#endif /* !UIP_TCP_CLOCK_RTO */
+  } else {
+    conn->due = conn->tick + 1;
+  }
+  wheel_link(conn);
+}
+#endif /* UIP_TCP_TIMER_WHEEL */
+#if UIP_TCP_CLOCK_RTO
+/*---------------------------------------------------------------------------*/
+/* Makes sure that uip_rexmit_expired() returns non-zero no later
+   than t clock ticks from now. */
+static void
+rexmit_arm(clock_time_t t)
+{
+  if(!rexmit_armed || t < timer_remaining(&rexmit_next)) {
+    timer_set(&rexmit_next, t);
+    rexmit_armed = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+rexmit_set(struct uip_conn *conn, clock_time_t rto)
+{
+  timer_set(&conn->rt, rto);
+  rexmit_arm(rto);
+}
+/*---------------------------------------------------------------------------*/
+/* Updates the round-trip time estimate with a new measurement, and
+   computes a new retransmission timeout as specified by RFC6298. */
+static void
+rtt_update(struct uip_conn *conn, clock_time_t r)
+{
+  clock_time_t delta;
+
+  if(conn->srtt == 0) {
+    conn->srtt = r << 3;
+    conn->rttvar = r << 1;
+  } else {
+    if(r > conn->srtt >> 3) {
+      delta = r - (conn->srtt >> 3);
+      conn->srtt += delta;
+    } else {
+      delta = (conn->srtt >> 3) - r;
+      conn->srtt -= delta;
+    }
+    conn->rttvar += delta - (conn->rttvar >> 2);
+  }
+  conn->rtoclk = (conn->srtt >> 3) + (conn->rttvar > 0? conn->rttvar: 1);
+  if(conn->rtoclk < RTO_MIN) {
+    conn->rtoclk = RTO_MIN;
+  } else if(conn->rtoclk > RTO_MAX) {
+    conn->rtoclk = RTO_MAX;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Starts timing a segment that ends len bytes after the oldest
+   unacknowledged byte, unless another segment already is timed. */
+static void
+rtt_start(struct uip_conn *conn, u16_t len)
+{
+  if(conn->rtt_seq == 0) {
+    conn->rtt_seq = len;
+    conn->rtt_start = clock_time();
+  }
+}
+/*---------------------------------------------------------------------------*/
+u8_t
+uip_rexmit_expired(void)
+{
+  if(rexmit_armed && timer_expired(&rexmit_next)) {
+    /* The timer is armed again for the connections that still have
+       outstanding data when they are checked. */
+    rexmit_armed = 0;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+uip_rexmit_remaining(clock_time_t max)
+{
+  clock_time_t t;
+
+  if(rexmit_armed) {
+    t = timer_remaining(&rexmit_next);
+    if(t < max) {
+      return t;
+    }
+  }
+  return max;
+}
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_TCP_DELAYED_ACK
+/*---------------------------------------------------------------------------*/
+/* Decides if the acknowledgment of the data segment that was just
+   processed may be delayed, and starts the delayed acknowledgment
+   timer if so. The flag is the one uip_process() was called with. */
+static u8_t
+ack_delay(struct uip_conn *conn, u8_t flag)
+{
+  if(conn->delack != 0 ||
+     conn->tcpstateflags != UIP_ESTABLISHED
+#if UIP_TCP_REORDER
+     /* Out-of-order data, and data that fills a hole, is
+	acknowledged at once (RFC 5681). */
+     || conn->ooq != NULL || flag == UIP_REORDER
+#endif /* UIP_TCP_REORDER */
+     ) {
+    return 0;
+  }
+  conn->delack = 1;
+  timer_set(&conn->at, ACK_DELAY);
+  rexmit_arm(ACK_DELAY);
+  UIP_STAT(++uip_stat.tcp.ackdelayed);
+  return 1;
+}
+#endif /* UIP_TCP_DELAYED_ACK */
+#if UIP_TCP_REORDER
+/*---------------------------------------------------------------------------*/
+#define OOQ_BUF(p) ((struct uip_tcpip_hdr *)&(p)->buf[UIP_LLH_LEN])
+
+/* Returns the signed distance from sequence number b to sequence
+   number a. */
+static long
+seq_diff(unsigned long a, unsigned long b)
+{
+  unsigned long d;
+
+  d = (a - b) & 0xffffffffUL;
+  if(d & 0x80000000UL) {
+    return -(long)(~d & 0x7fffffffUL) - 1;
+  }
+  return (long)d;
+}
+/*---------------------------------------------------------------------------*/
+static void
+ooq_free(struct uip_conn *conn)
+{
+  struct uip_packet *p;
+
+  while(conn->ooq != NULL) {
+    p = conn->ooq;
+    conn->ooq = p->next;
+    uip_packet_free(p);
+    UIP_STAT(++uip_stat.tcp.oodrop);
+  }
+  conn->ooqlen = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Queues a copy of the incoming segment, which carries data that
+   starts after rcv_nxt. The segment has a TCP header of hdrlen bytes
+   and uip_len bytes of data. */
+static void
+ooq_insert(struct uip_conn *conn, u8_t hdrlen)
+{
+  struct uip_packet *p, *prev, *q;
+  long d;
+
+  d = seq_diff(SEQ_GET(BUF->seqno), CONN_SEQ(conn->rcv_nxt));
+  if(d <= 0 || d + uip_len > UIP_RECEIVE_WINDOW) {
+    /* A retransmission of old data, or data outside the window. */
+    return;
+  }
+#if UIP_TCP_SACK
+  SEQ_LOAD(conn->ooqnew, BUF->seqno);
+#endif /* UIP_TCP_SACK */
+
+  /* Find the place of the segment in the queue. */
+  prev = NULL;
+  for(p = conn->ooq; p != NULL; p = p->next) {
+    d = seq_diff(SEQ_GET(BUF->seqno), SEQ_GET(OOQ_BUF(p)->seqno));
+    if(d == 0) {
+      /* The segment is already queued. */
+      UIP_STAT(++uip_stat.tcp.oodrop);
+      return;
+    }
+    if(d < 0) {
+      break;
+    }
+    prev = p;
+  }
+
+  /* Two packet buffers are left for the device driver, so that it
+     can still read the segment that fills the hole. */
+  if(conn->ooqlen >= UIP_TCP_REORDER || uip_packet_avail() <= 2) {
+    UIP_STAT(++uip_stat.tcp.oodrop);
+    return;
+  }
+  q = uip_packet_alloc();
+  if(q == NULL) {
+    UIP_STAT(++uip_stat.tcp.oodrop);
+    return;
+  }
+  q->len = UIP_IPH_LEN + hdrlen + uip_len;
+  memcpy(&q->buf[UIP_LLH_LEN], &uip_buf[UIP_LLH_LEN], q->len);
+  q->next = p;
+  if(prev == NULL) {
+    conn->ooq = q;
+  } else {
+    prev->next = q;
+  }
+  ++conn->ooqlen;
+  UIP_STAT(++uip_stat.tcp.ooqueued);
+}
+/*---------------------------------------------------------------------------*/
+u8_t
+uip_reorder_ready(struct uip_conn *conn)
+{
+  struct uip_packet *p;
+  long d;
+
+  while((p = conn->ooq) != NULL) {
+    d = seq_diff(SEQ_GET(OOQ_BUF(p)->seqno), CONN_SEQ(conn->rcv_nxt));
+    if(d > 0) {
+      /* There still is a hole before the first segment. */
+      return 0;
+    }
+    if(d == 0) {
+      /* The segment cannot be delivered while the application has
+	 stopped the data flow. */
+      return !(conn->tcpstateflags & UIP_STOPPED);
+    }
+    /* The segment starts before rcv_nxt, so its data has already been
+       received in some other segment. */
+    conn->ooq = p->next;
+    --conn->ooqlen;
+    uip_packet_free(p);
+    UIP_STAT(++uip_stat.tcp.oodrop);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Moves the first queued segment into uip_buf. */
+static void
+ooq_deliver(struct uip_conn *conn)
+{
+  struct uip_packet *p;
+
+  p = conn->ooq;
+  conn->ooq = p->next;
+  --conn->ooqlen;
+  memcpy(&uip_buf[UIP_LLH_LEN], &p->buf[UIP_LLH_LEN], p->len);
+  uip_len = p->len;
+  uip_packet_free(p);
+}
+#endif /* UIP_TCP_REORDER */
+#if UIP_TCP_SACK
+/*---------------------------------------------------------------------------*/
+/* Appends a SACK option that describes the data in the out-of-order
+   queue to the outgoing segment, which has no data or options. The
+   first block holds the most recently queued segment (RFC 2018,
+   section 4); the rest follow in sequence number order. */
+static void
+sack_output(struct uip_conn *conn)
+{
+  struct uip_packet *p;
+  u8_t *opts, *block;
+  u8_t n, newest;
+  unsigned long right, seq;
+
+  opts = &uip_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN];
+  n = 0;
+  newest = 0;
+  p = conn->ooq;
+  /* Block 0 is reserved for the newest data, which leaves room for
+     three more blocks in the 40 bytes of option space. */
+  while(p != NULL && n < 3) {
+    block = &opts[4 + 8 * (n + 1)];
+    memcpy(block, OOQ_BUF(p)->seqno, 4);
+    right = SEQ_GET(OOQ_BUF(p)->seqno);
+    /* Merge the segments that follow each other without a hole. */
+    do {
+      if(SEQ_EQ(OOQ_BUF(p)->seqno, conn->ooqnew)) {
+	newest = 1;
+	block = &opts[4];
+      }
+      seq = SEQ_GET(OOQ_BUF(p)->seqno) + p->len - UIP_IPH_LEN -
+	((OOQ_BUF(p)->tcpoffset >> 4) << 2);
+      if(seq_diff(seq, right) > 0) {
+	right = seq;
+      }
+      p = p->next;
+    } while(p != NULL && seq_diff(SEQ_GET(OOQ_BUF(p)->seqno), right) <= 0);
+    if(block == &opts[4]) {
+      memcpy(block, &opts[4 + 8 * (n + 1)], 4);
+    } else {
+      ++n;
+    }
+    SEQ_PUT(block + 4, right);
+  }
+  if(!newest) {
+    /* The newest segment was not queued, or is in a block that did
+       not fit. */
+    memmove(&opts[4], &opts[12], 8 * n);
+  } else {
+    ++n;
+  }
+  if(n == 0) {
+    return;
+  }
+  opts[0] = TCP_OPT_NOOP;
+  opts[1] = TCP_OPT_NOOP;
+  opts[2] = TCP_OPT_SACK;
+  opts[3] = 2 + 8 * n;
+  uip_len += 4 + 8 * n;
+  BUF->tcpoffset = ((uip_len - UIP_IPH_LEN) / 4) << 4;
+}
+#if UIP_TCP_CC
+/*---------------------------------------------------------------------------*/
+/* Marks the segments in flight that are covered by the SACK blocks of
+   the incoming acknowledgment. */
+static void
+sack_input(struct uip_conn *conn)
+{
+  u8_t *opts;
+  u8_t i, j, k, n;
+  u16_t off;
+  long left, right;
+
+  opts = &uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN];
+  n = ((BUF->tcpoffset >> 4) - 5) << 2;
+  for(i = 0; i < n && opts[i] != TCP_OPT_END;) {
+    if(opts[i] == TCP_OPT_NOOP) {
+      ++i;
+      continue;
+    }
+    if(i + 1 >= n || opts[i + 1] < 2 || i + opts[i + 1] > n) {
+      /* Malformed options. */
+      return;
+    }
+    if(opts[i] == TCP_OPT_SACK) {
+      for(j = i + 2; j + 8 <= i + opts[i + 1]; j += 8) {
+	left = seq_diff(SEQ_GET(&opts[j]), CONN_SEQ(conn->snd_nxt));
+	right = seq_diff(SEQ_GET(&opts[j + 4]), CONN_SEQ(conn->snd_nxt));
+	off = 0;
+	for(k = 0; k < conn->nseg; ++k) {
+	  if(left <= off && off + conn->seglen[k] <= right) {
+	    conn->sacked |= 1U << k;
+	  }
+	  off += conn->seglen[k];
+	}
+      }
+    }
+    i += opts[i + 1];
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Finds the oldest segment in flight that has not been retransmitted
+   during this loss recovery and that is missing at the remote host:
+   either the first segment, or a segment below one that the remote
+   host has selectively acknowledged. If there is one, it is marked as
+   retransmitted, uip_rexmit_off and uip_rexmit_len are set up for it,
+   and 1 is returned. */
+static u8_t
+sack_hole(struct uip_conn *conn)
+{
+  u16_t off;
+  u8_t i;
+
+  off = 0;
+  for(i = 0; i < conn->nseg && (i == 0 || (conn->sacked >> i) != 0); ++i) {
+    if(((conn->sacked | conn->rtxed) & (1U << i)) == 0) {
+      conn->rtxed |= 1U << i;
+      uip_rexmit_off = off;
+      uip_rexmit_len = conn->seglen[i];
+      return 1;
+    }
+    off += conn->seglen[i];
+  }
+  return 0;
+}
+#endif /* UIP_TCP_CC */
+#endif /* UIP_TCP_SACK */
+#if UIP_EPHEMERAL_PORTS
+/*---------------------------------------------------------------------------*/
+/* Allocates a local port that is not used by any other connection
+   allocated here, and returns it in network byte order, or 0 if all
+   ports are in use. The search starts at a random position in the
+   bitmap, so it normally finds a free port at once unless nearly all
+   of the range is in use. */
+static u16_t
+port_alloc(void)
+{
+  u16_t i, n;
+  u8_t bit;
+
+#if UIP_TCP_SEQ32
+  portrand = portrand * 1103515245UL + 12345 + iss;
+#else /* UIP_TCP_SEQ32 */
+  portrand = portrand * 1103515245UL + 12345 + iss[3];
+#endif /* UIP_TCP_SEQ32 */
+  i = (u16_t)((portrand >> 16) % UIP_EPHEMERAL_PORTS);
+  for(n = UIP_EPHEMERAL_PORTS; n > 0; --n) {
+    bit = 1 << (i & 7);
+    if(!(portmap[i >> 3] & bit)) {
+      portmap[i >> 3] |= bit;
+      return htons(PORT_FIRST + i);
+    }
+    if(++i == UIP_EPHEMERAL_PORTS) {
+      i = 0;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+port_free(u16_t port)
+{
+  port = ntohs(port) - PORT_FIRST;
+  portmap[port >> 3] &= ~(1 << (port & 7));
+}
+#if UIP_UDP
+/*---------------------------------------------------------------------------*/
+/* Marks a port that is bound explicitly as used, so that
+   port_alloc() does not hand it out as well. Returns 1 if the port
+   was reserved here, or 0 if it is outside of the ephemeral range or
+   already in use. */
+static u8_t
+port_reserve(u16_t port)
+{
+  u8_t bit;
+
+  port = ntohs(port);
+  if(port < PORT_FIRST || port >= PORT_FIRST + UIP_EPHEMERAL_PORTS) {
+    return 0;
+  }
+  port -= PORT_FIRST;
+  bit = 1 << (port & 7);
+  if(portmap[port >> 3] & bit) {
+    return 0;
+  }
+  portmap[port >> 3] |= bit;
+  return 1;
+}
+#endif /* UIP_UDP */
+#endif /* UIP_EPHEMERAL_PORTS */
+#if UIP_TCP_HASH || UIP_TCP_REORDER || UIP_EPHEMERAL_PORTS || \
+    UIP_DYNAMIC_TABLES || UIP_TCP_SENDBUFS
+/*---------------------------------------------------------------------------*/
+static void
+set_closed(struct uip_conn *conn)
+{
+#if UIP_TCP_HASH
+  conn_unhash(conn);
+#endif /* UIP_TCP_HASH */
+#if UIP_TCP_REORDER
+  ooq_free(conn);
+#endif /* UIP_TCP_REORDER */
+#if UIP_EPHEMERAL_PORTS
+  PORT_RELEASE(conn);
+#endif /* UIP_EPHEMERAL_PORTS */
+#if UIP_TCP_SENDBUFS
+  if(conn->sendbuf != NULL) {
+    uip_sendbuf_free(conn);
+  }
+#endif /* UIP_TCP_SENDBUFS */
+  conn->tcpstateflags = UIP_CLOSED;
+#if UIP_DYNAMIC_TABLES
+  /* Closed connections at the end of the table are no longer
+     visited. */
+  while(uip_conns_used > 1 &&
+	uip_conns[uip_conns_used - 1].tcpstateflags == UIP_CLOSED) {
+    --uip_conns_used;
+  }
+#endif /* UIP_DYNAMIC_TABLES */
+}
+#endif /* UIP_TCP_HASH || ... || UIP_TCP_SENDBUFS */
+#if UIP_TCP_TIME_WAIT_CONNS
+/*---------------------------------------------------------------------------*/
+/* Moves a connection that has entered TIME_WAIT to the TIME_WAIT
+   table and frees its slot. The oldest entry is replaced if the table
+   is full. */
+static void
+tw_enter(struct uip_conn *conn)
+{
+  register struct tw_entry *tw, *twr;
+
+  twr = NULL;
+  for(tw = &tw_conns[0]; tw <= &tw_conns[UIP_TCP_TIME_WAIT_CONNS - 1];
+      ++tw) {
+    if(tw->lport == 0) {
+      twr = tw;
+      break;
+    }
+    if(twr == NULL || tw->timer > twr->timer) {
+      twr = tw;
+    }
+  }
+
+  uip_ipaddr_copy(twr->ripaddr, conn->ripaddr);
+  twr->lport = conn->lport;
+  twr->rport = conn->rport;
+#if UIP_TCP_SEQ32
+  twr->rcv_nxt = conn->rcv_nxt;
+  twr->snd_nxt = conn->snd_nxt;
+#else /* UIP_TCP_SEQ32 */
+  memcpy(twr->rcv_nxt, conn->rcv_nxt, 4);
+  memcpy(twr->snd_nxt, conn->snd_nxt, 4);
+#endif /* UIP_TCP_SEQ32 */
+  twr->timer = conn->timer;
+
+  SET_CLOSED(conn);
+  UIP_STAT(++uip_stat.tcp.reclaimed);
+}
+/*---------------------------------------------------------------------------*/
+static void
+tw_periodic(void)
+{
+  register struct tw_entry *tw;
+
+  for(tw = &tw_conns[0]; tw <= &tw_conns[UIP_TCP_TIME_WAIT_CONNS - 1];
+      ++tw) {
+    if(tw->lport != 0 && ++tw->timer == UIP_TIME_WAIT_TIMEOUT) {
+      tw->lport = 0;
+    }
+  }
+}
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
+#if UIP_DYNAMIC_TABLES
+/*---------------------------------------------------------------------------*/
+int
+uip_settables(const struct uip_tables *tables)
+{
+  if(tables->conns == 0 || tables->listenports == 0) {
+    return 0;
+  }
+  conns_max = tables->conns;
+  listenports_max = tables->listenports;
+  free(uip_conns);
+  free(uip_listenports);
+  uip_conns = malloc(conns_max * sizeof(struct uip_conn));
+  uip_listenports = malloc(listenports_max * sizeof(u16_t));
+  if(uip_conns == NULL || uip_listenports == NULL) {
+    return 0;
+  }
+#if UIP_TCP_HASH
+  free(listen_next);
+  listen_next = malloc(listenports_max * sizeof(u16_t));
+  if(listen_next == NULL) {
+    return 0;
+  }
+#endif /* UIP_TCP_HASH */
+#if UIP_UDP
+  udp_conns_max = tables->udp_conns;
+  free(uip_udp_conns);
+  uip_udp_conns = malloc(udp_conns_max * sizeof(struct uip_udp_conn));
+  if(uip_udp_conns == NULL && udp_conns_max > 0) {
+    return 0;
+  }
+#endif /* UIP_UDP */
+  return 1;
+}
+#endif /* UIP_DYNAMIC_TABLES */
+/*---------------------------------------------------------------------------*/
 void
 uip_init(void)
 {
-  for(c = 0; c < UIP_LISTENPORTS; ++c) {
-    uip_listenports[c] = 0;
+  register struct uip_conn *conn;
+  u16_t *port;
+
+#if UIP_DYNAMIC_TABLES
+  /* All entries of the tables are initialized, but only the first
+     ones are used to begin with. */
+  uip_conns_used = conns_max;
+  uip_listenports_used = listenports_max;
+#if UIP_UDP
+  uip_udp_conns_used = udp_conns_max;
+#endif /* UIP_UDP */
+#endif /* UIP_DYNAMIC_TABLES */
+  for(port = &uip_listenports[0];
+      port <= &uip_listenports[UIP_LISTENPORTS - 1]; ++port) {
+    *port = 0;
   }
-  for(c = 0; c < UIP_CONNS; ++c) {
-    uip_conns[c].tcpstateflags = UIP_CLOSED;
+  for(conn = &uip_conns[0]; conn <= &uip_conns[UIP_CONNS - 1]; ++conn) {
+    conn->tcpstateflags = UIP_CLOSED;
+#if UIP_TCP_TIMER_WHEEL
+    conn->wslot = WHEEL_NONE;
+#endif /* UIP_TCP_TIMER_WHEEL */
+#if UIP_TCP_REORDER
+    conn->ooq = NULL;
+    conn->ooqlen = 0;
+#endif /* UIP_TCP_REORDER */
+#if UIP_EPHEMERAL_PORTS
+    conn->ephemeral = 0;
+#endif /* UIP_EPHEMERAL_PORTS */
+#if UIP_TCP_SENDBUFS
+    conn->sendbuf = NULL;
+#endif /* UIP_TCP_SENDBUFS */
   }
-#if UIP_ACTIVE_OPEN
+#if UIP_TCP_HASH
+  memset(conn_hash, 0, sizeof(conn_hash));
+  memset(listen_hash, 0, sizeof(listen_hash));
+#endif /* UIP_TCP_HASH */
+#if UIP_TCP_FASTPATH
+  lastconn = &uip_conns[0];
+#endif /* UIP_TCP_FASTPATH */
+#if UIP_TCP_TIMER_WHEEL
+  memset(wheel, 0, sizeof(wheel));
+#endif /* UIP_TCP_TIMER_WHEEL */
+#if UIP_TCP_CLOCK_RTO
+  rexmit_armed = 0;
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_PACKETS
+  uip_packet_init();
+#endif /* UIP_PACKETS */
+#if UIP_TCP_SENDBUFS
+  uip_sendbuf_init();
+#endif /* UIP_TCP_SENDBUFS */
+#if UIP_ACTIVE_OPEN && !UIP_EPHEMERAL_PORTS
   lastport = 1024;
-#endif /* UIP_ACTIVE_OPEN */
+#endif /* UIP_ACTIVE_OPEN && !UIP_EPHEMERAL_PORTS */
+#if UIP_EPHEMERAL_PORTS
+  memset(portmap, 0, sizeof(portmap));
+#endif /* UIP_EPHEMERAL_PORTS */
+#if UIP_TCP_TIME_WAIT_CONNS
+  memset(tw_conns, 0, sizeof(tw_conns));
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
 
 #if UIP_UDP
   for(c = 0; c < UIP_UDP_CONNS; ++c) {
     uip_udp_conns[c].lport = 0;
+#if UIP_EPHEMERAL_PORTS
+    uip_udp_conns[c].ephemeral = 0;
+#endif /* UIP_EPHEMERAL_PORTS */
   }
 #endif /* UIP_UDP */
+#if UIP_DYNAMIC_TABLES
+  uip_conns_used = 1;
+  uip_listenports_used = 1;
+#if UIP_UDP
+  uip_udp_conns_used = 0;
+#endif /* UIP_UDP */
+#endif /* UIP_DYNAMIC_TABLES */
   
 
   /* IPv4 initialization. */
@@ -407,6 +1428,14 @@ struct uip_conn *
 uip_connect(uip_ipaddr_t *ripaddr, u16_t rport)
 {
   register struct uip_conn *conn, *cconn;
+#if UIP_EPHEMERAL_PORTS
+  u16_t port;
+
+  port = port_alloc();
+  if(port == 0) {
+    return 0;
+  }
+#else /* UIP_EPHEMERAL_PORTS */
   
   /* Find an unused local port. */
  again:
@@ -418,51 +1447,112 @@ uip_connect(uip_ipaddr_t *ripaddr, u16_t rport)
 
   /* Check if this port is already in use, and if so try to find
      another one. */
-  for(c = 0; c < UIP_CONNS; ++c) {
-    conn = &uip_conns[c];
+  for(conn = &uip_conns[0]; conn <= &uip_conns[UIP_CONNS - 1]; ++conn) {
     if(conn->tcpstateflags != UIP_CLOSED &&
        conn->lport == htons(lastport)) {
       goto again;
     }
   }
+#endif /* UIP_EPHEMERAL_PORTS */
 
   conn = 0;
-  for(c = 0; c < UIP_CONNS; ++c) {
-    cconn = &uip_conns[c];
+  for(cconn = &uip_conns[0]; cconn <= &uip_conns[UIP_CONNS - 1]; ++cconn) {
     if(cconn->tcpstateflags == UIP_CLOSED) {
       conn = cconn;
       break;
     }
     if(cconn->tcpstateflags == UIP_TIME_WAIT) {
+#if UIP_TCP_TIMER_WHEEL
+      wheel_sync(cconn, uip_ticks);
+#endif /* UIP_TCP_TIMER_WHEEL */
       if(conn == 0 ||
 	 cconn->timer > conn->timer) {
 	conn = cconn;
       }
     }
   }
+#if UIP_DYNAMIC_TABLES
+  if((conn == 0 || conn->tcpstateflags != UIP_CLOSED) &&
+     uip_conns_used < conns_max) {
+    /* Use a new entry rather than one in TIME_WAIT. */
+    conn = &uip_conns[uip_conns_used++];
+  }
+#endif /* UIP_DYNAMIC_TABLES */
 
   if(conn == 0) {
+#if UIP_EPHEMERAL_PORTS
+    port_free(port);
+#endif /* UIP_EPHEMERAL_PORTS */
     return 0;
   }
+
+#if UIP_TCP_HASH
+  if(conn->tcpstateflags != UIP_CLOSED) {
+    /* We are reusing a connection in TIME_WAIT. */
+    conn_unhash(conn);
+  }
+#endif /* UIP_TCP_HASH */
+#if UIP_EPHEMERAL_PORTS
+  PORT_RELEASE(conn);
+#endif /* UIP_EPHEMERAL_PORTS */
+#if UIP_TCP_REORDER
+  ooq_free(conn);
+#endif /* UIP_TCP_REORDER */
   
   conn->tcpstateflags = UIP_SYN_SENT;
 
+#if UIP_TCP_SEQ32
+  conn->snd_nxt = iss;
+#else /* UIP_TCP_SEQ32 */
   conn->snd_nxt[0] = iss[0];
   conn->snd_nxt[1] = iss[1];
   conn->snd_nxt[2] = iss[2];
   conn->snd_nxt[3] = iss[3];
+#endif /* UIP_TCP_SEQ32 */
 
   conn->initialmss = conn->mss = UIP_TCP_MSS;
+#if UIP_TCP_WINDOW_SCALE
+  conn->snd_wscale = 0;
+  conn->rcv_wscale = UIP_TCP_WINDOW_SCALE;
+#endif /* UIP_TCP_WINDOW_SCALE */
+#if UIP_TCP_SACK
+  conn->sackok = 1;
+#endif /* UIP_TCP_SACK */
   
   conn->len = 1;   /* TCP length of the SYN is one. */
   conn->nrtx = 0;
+#if UIP_TCP_DELAYED_ACK
+  conn->delack = 0;
+#endif /* UIP_TCP_DELAYED_ACK */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+  conn->nseg = 0;
+  conn->snd_wnd = 0;
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
   conn->timer = 1; /* Send the SYN next time around. */
   conn->rto = UIP_RTO;
   conn->sa = 0;
   conn->sv = 16;   /* Initial value of the RTT variance. */
+#if UIP_TCP_CLOCK_RTO
+  conn->srtt = conn->rttvar = 0;
+  conn->rtoclk = RTO_INIT;
+  conn->rtt_seq = 0;
+  rexmit_set(conn, 0);
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_EPHEMERAL_PORTS
+  conn->lport = port;
+  conn->ephemeral = 1;
+#else /* UIP_EPHEMERAL_PORTS */
   conn->lport = htons(lastport);
+#endif /* UIP_EPHEMERAL_PORTS */
   conn->rport = rport;
   uip_ipaddr_copy(&conn->ripaddr, ripaddr);
+#if UIP_TCP_HASH
+  conn_hash_insert(conn);
+#endif /* UIP_TCP_HASH */
+#if UIP_TCP_TIMER_WHEEL
+  conn->tick = uip_ticks;
+  wheel_update(conn);
+#endif /* UIP_TCP_TIMER_WHEEL */
   
   return conn;
 }
@@ -473,6 +1563,14 @@ struct uip_udp_conn *
 uip_udp_new(uip_ipaddr_t *ripaddr, u16_t rport)
 {
   register struct uip_udp_conn *conn;
+#if UIP_EPHEMERAL_PORTS
+  u16_t port;
+
+  port = port_alloc();
+  if(port == 0) {
+    return 0;
+  }
+#else /* UIP_EPHEMERAL_PORTS */
   
   /* Find an unused local port. */
  again:
@@ -487,6 +1585,7 @@ uip_udp_new(uip_ipaddr_t *ripaddr, u16_t rport)
       goto again;
     }
   }
+#endif /* UIP_EPHEMERAL_PORTS */
 
 
   conn = 0;
@@ -496,12 +1595,25 @@ uip_udp_new(uip_ipaddr_t *ripaddr, u16_t rport)
       break;
     }
   }
+#if UIP_DYNAMIC_TABLES
+  if(conn == 0 && uip_udp_conns_used < udp_conns_max) {
+    conn = &uip_udp_conns[uip_udp_conns_used++];
+  }
+#endif /* UIP_DYNAMIC_TABLES */
 
   if(conn == 0) {
+#if UIP_EPHEMERAL_PORTS
+    port_free(port);
+#endif /* UIP_EPHEMERAL_PORTS */
     return 0;
   }
   
+#if UIP_EPHEMERAL_PORTS
+  conn->lport = port;
+  conn->ephemeral = 1;
+#else /* UIP_EPHEMERAL_PORTS */
   conn->lport = HTONS(lastport);
+#endif /* UIP_EPHEMERAL_PORTS */
   conn->rport = rport;
   if(ripaddr == NULL) {
     memset(conn->ripaddr, 0, sizeof(uip_ipaddr_t));
@@ -512,14 +1624,67 @@ uip_udp_new(uip_ipaddr_t *ripaddr, u16_t rport)
   
   return conn;
 }
+/*---------------------------------------------------------------------------*/
+#if UIP_EPHEMERAL_PORTS
+void
+uip_udp_setport(struct uip_udp_conn *conn, u16_t port)
+{
+  PORT_RELEASE(conn);
+  conn->lport = port;
+  if(port != 0 && port_reserve(port)) {
+    conn->ephemeral = 1;
+  }
+}
+#endif /* UIP_EPHEMERAL_PORTS */
 #endif /* UIP_UDP */
 /*---------------------------------------------------------------------------*/
+#if UIP_TCP_HASH
+void
+uip_unlisten(u16_t port)
+{
+  u16_t *p;
+
+  for(p = &listen_hash[LISTEN_HASH(port)]; *p != 0;
+      p = &listen_next[*p - 1]) {
+    if(uip_listenports[*p - 1] == port) {
+      uip_listenports[*p - 1] = 0;
+      *p = listen_next[*p - 1];
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_listen(u16_t port)
+{
+  u16_t i;
+
+  for(i = 0; i < UIP_LISTENPORTS; ++i) {
+    if(uip_listenports[i] == 0) {
+      break;
+    }
+  }
+#if UIP_DYNAMIC_TABLES
+  if(i == UIP_LISTENPORTS && uip_listenports_used < listenports_max) {
+    ++uip_listenports_used;
+  }
+#endif /* UIP_DYNAMIC_TABLES */
+  if(i < UIP_LISTENPORTS) {
+    uip_listenports[i] = port;
+    listen_next[i] = listen_hash[LISTEN_HASH(port)];
+    listen_hash[LISTEN_HASH(port)] = i + 1;
+  }
+}
+#else /* UIP_TCP_HASH */
 void
 uip_unlisten(u16_t port)
 {
-  for(c = 0; c < UIP_LISTENPORTS; ++c) {
-    if(uip_listenports[c] == port) {
-      uip_listenports[c] = 0;
+  u16_t *p;
+
+  for(p = &uip_listenports[0];
+      p <= &uip_listenports[UIP_LISTENPORTS - 1]; ++p) {
+    if(*p == port) {
+      *p = 0;
       return;
     }
   }
@@ -528,13 +1693,54 @@ uip_unlisten(u16_t port)
 void
 uip_listen(u16_t port)
 {
-  for(c = 0; c < UIP_LISTENPORTS; ++c) {
-    if(uip_listenports[c] == 0) {
-      uip_listenports[c] = port;
+  u16_t *p;
+
+  for(p = &uip_listenports[0];
+      p <= &uip_listenports[UIP_LISTENPORTS - 1]; ++p) {
+    if(*p == 0) {
+      *p = port;
       return;
     }
   }
+#if UIP_DYNAMIC_TABLES
+  if(uip_listenports_used < listenports_max) {
+    uip_listenports[uip_listenports_used++] = port;
+  }
+#endif /* UIP_DYNAMIC_TABLES */
+}
+#endif /* UIP_TCP_HASH */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+u16_t
+uip_sendroom(struct uip_conn *conn)
+{
+  u16_t wnd;
+
+  if((conn->tcpstateflags & UIP_TS_MASK) != UIP_ESTABLISHED ||
+     conn->nseg == UIP_TCP_WINDOW_SEGMENTS) {
+    return 0;
+  }
+
+  /* If the remote host advertises a zero window, we let a full
+     segment through when nothing else is in flight. The segment will
+     be retransmitted until the window opens up again, which makes it
+     work as a window probe. */
+  wnd = conn->snd_wnd;
+  if(wnd == 0 && conn->len == 0) {
+    wnd = conn->mss;
+  }
+#if UIP_TCP_CC
+  if(wnd > conn->cwnd) {
+    wnd = conn->cwnd;
+  }
+#endif /* UIP_TCP_CC */
+  if(wnd <= conn->len) {
+    return 0;
+  }
+  wnd -= conn->len;
+  return wnd > conn->mss? conn->mss: wnd;
 }
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
 /*---------------------------------------------------------------------------*/
 /* XXX: IP fragment reassembly: not well-tested. */
 
@@ -645,46 +1851,356 @@ uip_reass(void)
 	goto nullreturn;
       }
 
-      /* If we have come this far, we have a full packet in the
-	 buffer, so we allocate a pbuf and copy the packet into it. We
-	 also reset the timer. */
-      uip_reasstmr = 0;
-      memcpy(BUF, FBUF, uip_reasslen);
+      /* If we have come this far, we have a full packet in the
+	 buffer, so we allocate a pbuf and copy the packet into it. We
+	 also reset the timer. */
+      uip_reasstmr = 0;
+      memcpy(BUF, FBUF, uip_reasslen);
+
+      /* Pretend to be a "normal" (i.e., not fragmented) IP packet
+	 from now on. The header checksum is updated for the two
+	 changed fields, so a bad checksum on the stored header is
+	 still caught by the check in uip_process(). */
+      BUF->ipchksum = uip_chksum_update16(BUF->ipchksum,
+					  (BUF->ipoffset[0] << 8) |
+					  BUF->ipoffset[1], 0);
+      BUF->ipchksum = uip_chksum_update16(BUF->ipchksum,
+					  (BUF->len[0] << 8) | BUF->len[1],
+					  uip_reasslen);
+      BUF->ipoffset[0] = BUF->ipoffset[1] = 0;
+      BUF->len[0] = uip_reasslen >> 8;
+      BUF->len[1] = uip_reasslen & 0xff;
+
+      return uip_reasslen;
+    }
+  }
+
+ nullreturn:
+  return 0;
+}
+#endif /* UIP_REASSEMBLY */
+/*---------------------------------------------------------------------------*/
+static void
+uip_add_rcv_nxt(u16_t n)
+{
+#if UIP_TCP_SEQ32
+  uip_conn->rcv_nxt += n;
+#else /* UIP_TCP_SEQ32 */
+  uip_add32(uip_conn->rcv_nxt, n);
+  uip_conn->rcv_nxt[0] = uip_acc32[0];
+  uip_conn->rcv_nxt[1] = uip_acc32[1];
+  uip_conn->rcv_nxt[2] = uip_acc32[2];
+  uip_conn->rcv_nxt[3] = uip_acc32[3];
+#endif /* UIP_TCP_SEQ32 */
+}
+/*---------------------------------------------------------------------------*/
+/* Parses the options of an incoming SYN or SYNACK segment. */
+static void
+tcp_options(struct uip_conn *conn)
+{
+#if UIP_TCP_WINDOW_SCALE
+  /* Window scaling is only used if both ends send the option. */
+  conn->snd_wscale = conn->rcv_wscale = 0;
+#endif /* UIP_TCP_WINDOW_SCALE */
+#if UIP_TCP_SACK
+  /* So are selective acknowledgments. */
+  conn->sackok = 0;
+#if UIP_TCP_CC
+  conn->sacked = conn->rtxed = 0;
+#endif /* UIP_TCP_CC */
+#endif /* UIP_TCP_SACK */
+  if((BUF->tcpoffset & 0xf0) > 0x50) {
+    for(c = 0; c < ((BUF->tcpoffset >> 4) - 5) << 2 ;) {
+      opt = uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + c];
+      if(opt == TCP_OPT_END) {
+	/* End of options. */
+	break;
+      } else if(opt == TCP_OPT_NOOP) {
+	++c;
+	/* NOP option. */
+      } else if(opt == TCP_OPT_MSS &&
+		uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c] == TCP_OPT_MSS_LEN) {
+	/* An MSS option with the right option length. */
+	tmp16 = ((u16_t)uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 2 + c] << 8) |
+	  (u16_t)uip_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN + 3 + c];
+	conn->initialmss = conn->mss =
+	  tmp16 > UIP_TCP_MSS? UIP_TCP_MSS: tmp16;
+#if UIP_TCP_WINDOW_SCALE || UIP_TCP_SACK
+	c += TCP_OPT_MSS_LEN;
+#else /* UIP_TCP_WINDOW_SCALE || UIP_TCP_SACK */
+
+	/* And we are done processing options. */
+	break;
+#endif /* UIP_TCP_WINDOW_SCALE || UIP_TCP_SACK */
+#if UIP_TCP_WINDOW_SCALE
+      } else if(opt == TCP_OPT_WS &&
+		uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c] == TCP_OPT_WS_LEN) {
+	/* A window scale option with the right option length. Shift
+	   counts larger than 14 are treated as 14. */
+	opt = uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 2 + c];
+	conn->snd_wscale = opt > 14? 14: opt;
+	conn->rcv_wscale = UIP_TCP_WINDOW_SCALE;
+	c += TCP_OPT_WS_LEN;
+#endif /* UIP_TCP_WINDOW_SCALE */
+#if UIP_TCP_SACK
+      } else if(opt == TCP_OPT_SACK_PERM &&
+		uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c] ==
+		TCP_OPT_SACK_PERM_LEN) {
+	/* The remote host accepts selective acknowledgments. */
+	conn->sackok = 1;
+	c += TCP_OPT_SACK_PERM_LEN;
+#endif /* UIP_TCP_SACK */
+      } else {
+	/* All other options have a length field, so that we easily
+	   can skip past them. */
+	if(uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c] == 0) {
+	  /* If the length field is zero, the options are malformed
+	     and we don't process them further. */
+	  break;
+	}
+	c += uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c];
+      }
+    }
+  }
+}
+#if UIP_TCP_SYNCOOKIES
+/*---------------------------------------------------------------------------*/
+/* The MSS values that a SYN cookie can hold. */
+static const u16_t cookie_mss[4] = {536, 1300, 1440, 1460};
+
+/* The time for which a SYN cookie is valid, in clock ticks. Cookies
+   from the current and the previous period are accepted. */
+#define COOKIE_PERIOD ((unsigned long)64 * CLOCK_SECOND)
 
-      /* Pretend to be a "normal" (i.e., not fragmented) IP packet
-	 from now on. */
-      BUF->ipoffset[0] = BUF->ipoffset[1] = 0;
-      BUF->len[0] = uip_reasslen >> 8;
-      BUF->len[1] = uip_reasslen & 0xff;
-      BUF->ipchksum = 0;
-      BUF->ipchksum = ~(uip_ipchksum());
+/* Returns the MSS option of the incoming SYN, or the default MSS if
+   the SYN has none. */
+static u16_t
+syn_mss(void)
+{
+  u8_t *opts;
+  u8_t i, n;
 
-      return uip_reasslen;
+  if((BUF->tcpoffset & 0xf0) > 0x50) {
+    opts = &uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN];
+    n = ((BUF->tcpoffset >> 4) - 5) << 2;
+    for(i = 0; i < n && opts[i] != TCP_OPT_END;) {
+      if(opts[i] == TCP_OPT_NOOP) {
+	++i;
+	continue;
+      }
+      if(i + 1 >= n || opts[i + 1] < 2) {
+	/* Malformed options. */
+	break;
+      }
+      if(opts[i] == TCP_OPT_MSS && opts[i + 1] == TCP_OPT_MSS_LEN &&
+	 i + TCP_OPT_MSS_LEN <= n) {
+	return ((u16_t)opts[i + 2] << 8) | opts[i + 3];
+      }
+      i += opts[i + 1];
     }
   }
+  return 536;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+cookie_mix(unsigned long h, u16_t w)
+{
+  h = ((h ^ w) * 0x9e3779b1UL) & 0xffffffffUL;
+  return h ^ (h >> 15);
+}
+/*---------------------------------------------------------------------------*/
+/* Hashes the addresses and ports of the incoming segment together
+   with the secret and the cookie period. */
+static unsigned long
+cookie_hash(unsigned long period)
+{
+  unsigned long h;
+  u8_t i;
 
- nullreturn:
-  return 0;
+  h = cookie_secret ^ period;
+  for(i = 0; i < sizeof(uip_ipaddr_t) / 2; ++i) {
+    h = cookie_mix(h, BUF->srcipaddr[i]);
+  }
+  h = cookie_mix(h, BUF->srcport);
+  return cookie_mix(h, BUF->destport);
 }
-#endif /* UIP_REASSEMBLY */
 /*---------------------------------------------------------------------------*/
+/* Returns the SYN cookie for the incoming SYN, which is the distance
+   from the initial sequence number of the remote host to ours. The
+   low four bits hold the cookie period and the MSS of the remote
+   host; the rest is a hash that only we can compute. */
+static unsigned long
+cookie_make(void)
+{
+  unsigned long period;
+  u16_t mss;
+  u8_t i;
+
+  period = (unsigned long)clock_time() / COOKIE_PERIOD;
+  mss = syn_mss();
+  i = 3;
+  while(i > 0 && cookie_mss[i] > mss) {
+    --i;
+  }
+  return (cookie_hash(period) & 0xfffffff0UL) | ((period & 3) << 2) | i;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks the SYN cookie that the incoming acknowledgment returns.
+   Returns the MSS of the remote host, or zero if the cookie is not
+   valid. */
+static u16_t
+cookie_check(void)
+{
+  unsigned long v, period, d;
+
+  v = (SEQ_GET(BUF->ackno) - SEQ_GET(BUF->seqno)) & 0xffffffffUL;
+  period = (unsigned long)clock_time() / COOKIE_PERIOD;
+  d = (period - (v >> 2)) & 3;
+  if(d > 1 ||
+     ((cookie_hash(period - d) ^ v) & 0xfffffff0UL) != 0) {
+    return 0;
+  }
+  return cookie_mss[v & 3];
+}
+#endif /* UIP_TCP_SYNCOOKIES */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+/*---------------------------------------------------------------------------*/
+/* Returns the window advertised in the incoming segment. */
+static u16_t
+snd_window(struct uip_conn *conn)
+{
+  u16_t wnd;
+
+  wnd = ((u16_t)BUF->wnd[0] << 8) + (u16_t)BUF->wnd[1];
+#if UIP_TCP_WINDOW_SCALE
+  /* The window in a SYN segment is never scaled. Since we never have
+     more than 64 kilobytes in flight, larger windows are clamped. */
+  if(!(BUF->flags & TCP_SYN) && conn->snd_wscale > 0) {
+    if(wnd > (0xffff >> conn->snd_wscale)) {
+      return 0xffff;
+    }
+    wnd <<= conn->snd_wscale;
+  }
+#endif /* UIP_TCP_WINDOW_SCALE */
+  return wnd;
+}
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+#if UIP_TCP_WINDOW_SCALE || UIP_PACKETS
+/*---------------------------------------------------------------------------*/
+/* Fills in the window field of the outgoing segment. */
 static void
-uip_add_rcv_nxt(u16_t n)
+rcv_window(struct uip_conn *conn)
 {
-  uip_add32(uip_conn->rcv_nxt, n);
-  uip_conn->rcv_nxt[0] = uip_acc32[0];
-  uip_conn->rcv_nxt[1] = uip_acc32[1];
-  uip_conn->rcv_nxt[2] = uip_acc32[2];
-  uip_conn->rcv_nxt[3] = uip_acc32[3];
+  unsigned long wnd;
+
+  wnd = UIP_RECEIVE_WINDOW;
+#if UIP_PACKETS
+  /* Incoming segments are queued in the packet buffers until they
+     have been processed, so the window is limited to what fits in
+     the pool. It does not follow the number of free buffers, which
+     changes with every batch of frames that the driver reads: the
+     remote host only counts an acknowledgment as a duplicate if the
+     window is unchanged (RFC5681), so a moving window would keep it
+     from retransmitting a lost segment early. */
+  if(wnd > (unsigned long)UIP_PACKETS * UIP_TCP_MSS) {
+    wnd = (unsigned long)UIP_PACKETS * UIP_TCP_MSS;
+  }
+#endif /* UIP_PACKETS */
+#if UIP_TCP_WINDOW_SCALE
+  /* The window in a SYN segment, or in a segment that does not
+     belong to a connection, is never scaled. */
+  if(conn != NULL && !(BUF->flags & TCP_SYN)) {
+    wnd >>= conn->rcv_wscale;
+  }
+#endif /* UIP_TCP_WINDOW_SCALE */
+  if(wnd > 0xffff) {
+    wnd = 0xffff;
+  }
+  BUF->wnd[0] = wnd >> 8;
+  BUF->wnd[1] = wnd & 0xff;
+}
+#endif /* UIP_TCP_WINDOW_SCALE || UIP_PACKETS */
+#if UIP_TCP_TIMER_WHEEL
+/*---------------------------------------------------------------------------*/
+void
+uip_periodic_tick(void)
+{
+  struct uip_conn *conn, *next;
+
+  ++uip_ticks;
+#if UIP_TCP_TIME_WAIT_CONNS
+  tw_periodic();
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
+#if UIP_REASSEMBLY
+  if(uip_reasstmr != 0) {
+    --uip_reasstmr;
+  }
+#endif /* UIP_REASSEMBLY */
+  /* Increase the initial sequence number. */
+#if UIP_TCP_SEQ32
+  ++iss;
+#else /* UIP_TCP_SEQ32 */
+  if(++iss[3] == 0) {
+    if(++iss[2] == 0) {
+      if(++iss[1] == 0) {
+	++iss[0];
+      }
+    }
+  }
+#endif /* UIP_TCP_SEQ32 */
+
+  /* Move the connections that are due in the coming WHEEL_SLOTS ticks
+     down to the first level. */
+  if((uip_ticks & WHEEL_MASK) == 0) {
+    conn = wheel[WHEEL_SLOTS + ((uip_ticks >> WHEEL_BITS) & WHEEL_MASK)];
+    wheel[WHEEL_SLOTS + ((uip_ticks >> WHEEL_BITS) & WHEEL_MASK)] = NULL;
+    for(; conn != NULL; conn = next) {
+      next = conn->wnext;
+      wheel_link(conn);
+    }
+  }
+
+  conn = wheel[uip_ticks & WHEEL_MASK];
+  wheel[uip_ticks & WHEEL_MASK] = NULL;
+  for(; conn != NULL; conn = next) {
+    next = conn->wnext;
+    wheel_link(conn);
+  }
+}
+/*---------------------------------------------------------------------------*/
+struct uip_conn *
+uip_periodic_due(void)
+{
+  struct uip_conn *conn;
+
+  conn = wheel[WHEEL_DUE];
+  if(conn != NULL) {
+    /* The connection is rescheduled when it is processed. Until then,
+       it is kept due in the next tick. */
+    wheel_unlink(conn);
+    conn->due = uip_ticks + 1;
+    wheel_link(conn);
+  }
+  return conn;
 }
+#endif /* UIP_TCP_TIMER_WHEEL */
 /*---------------------------------------------------------------------------*/
 void
 uip_process(u8_t flag)
 {
   register struct uip_conn *uip_connr = uip_conn;
+#if UIP_TCP_SEQ32
+  u32_t acked;
+#endif /* UIP_TCP_SEQ32 */
+
+#if UIP_ZEROCOPY
+  uip_reflen = uip_refsumlen = 0;
+  sendref = NULL;
+#endif /* UIP_ZEROCOPY */
 
 #if UIP_UDP
   if(flag == UIP_UDP_SEND_CONN) {
+    uip_connr = NULL;
     goto udp_send;
   }
 #endif /* UIP_UDP */
@@ -694,8 +2210,11 @@ uip_process(u8_t flag)
   /* Check if we were invoked because of a poll request for a
      particular connection. */
   if(flag == UIP_POLL_REQUEST) {
-    if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
-       !uip_outstanding(uip_connr)) {
+#if UIP_TCP_TIMER_WHEEL
+    wheel_sync(uip_connr, uip_ticks);
+#endif /* UIP_TCP_TIMER_WHEEL */
+    if(CAN_POLL(uip_connr)) {
+	uip_slen = 0;
 	uip_flags = UIP_POLL;
 	UIP_APPCALL();
 	goto appsend;
@@ -704,12 +2223,30 @@ uip_process(u8_t flag)
     
     /* Check if we were invoked because of the perodic timer fireing. */
   } else if(flag == UIP_TIMER) {
+#if UIP_TCP_TIMER_WHEEL
+    /* The reassembly timer and the initial sequence number are
+       updated by uip_periodic_tick(). The timer of the connection is
+       counted forward over the ticks in which it was not due, and
+       then for this tick below. */
+    if(uip_connr->tick != uip_ticks) {
+      wheel_sync(uip_connr, uip_ticks - 1);
+      uip_connr->tick = uip_ticks;
+    }
+#else /* UIP_TCP_TIMER_WHEEL */
+#if UIP_TCP_TIME_WAIT_CONNS
+    if(uip_connr == &uip_conns[0]) {
+      tw_periodic();
+    }
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
 #if UIP_REASSEMBLY
     if(uip_reasstmr != 0) {
       --uip_reasstmr;
     }
 #endif /* UIP_REASSEMBLY */
     /* Increase the initial sequence number. */
+#if UIP_TCP_SEQ32
+    ++iss;
+#else /* UIP_TCP_SEQ32 */
     if(++iss[3] == 0) {
       if(++iss[2] == 0) {
 	if(++iss[1] == 0) {
@@ -717,6 +2254,8 @@ uip_process(u8_t flag)
 	}
       }
     }
+#endif /* UIP_TCP_SEQ32 */
+#endif /* UIP_TCP_TIMER_WHEEL */
 
     /* Reset the length variables. */
     uip_len = 0;
@@ -730,19 +2269,26 @@ uip_process(u8_t flag)
        uip_connr->tcpstateflags == UIP_FIN_WAIT_2) {
       ++(uip_connr->timer);
       if(uip_connr->timer == UIP_TIME_WAIT_TIMEOUT) {
-	uip_connr->tcpstateflags = UIP_CLOSED;
+	SET_CLOSED(uip_connr);
       }
     } else if(uip_connr->tcpstateflags != UIP_CLOSED) {
       /* If the connection has outstanding data, we increase the
 	 connection's timer and see if it has reached the RTO value
 	 in which case we retransmit. */
       if(uip_outstanding(uip_connr)) {
+#if UIP_TCP_CLOCK_RTO
+	if(!timer_expired(&uip_connr->rt)) {
+	  rexmit_set(uip_connr, timer_remaining(&uip_connr->rt));
+	} else {
+	rexmit:
+#else /* UIP_TCP_CLOCK_RTO */
 	if(uip_connr->timer-- == 0) {
+#endif /* UIP_TCP_CLOCK_RTO */
 	  if(uip_connr->nrtx == UIP_MAXRTX ||
 	     ((uip_connr->tcpstateflags == UIP_SYN_SENT ||
 	       uip_connr->tcpstateflags == UIP_SYN_RCVD) &&
 	      uip_connr->nrtx == UIP_MAXSYNRTX)) {
-	    uip_connr->tcpstateflags = UIP_CLOSED;
+	    SET_CLOSED(uip_connr);
 
 	    /* We call UIP_APPCALL() with uip_flags set to
 	       UIP_TIMEDOUT to inform the application that the
@@ -756,9 +2302,24 @@ uip_process(u8_t flag)
 	  }
 
 	  /* Exponential backoff. */
+#if UIP_TCP_CLOCK_RTO
+	  /* The retransmitted segment must not be timed (Karn's
+	     algorithm), and the backed off timeout is kept until a new
+	     round-trip time has been measured. */
+	  if(uip_connr->nrtx > 0 ||
+	     uip_connr->tcpstateflags != UIP_SYN_SENT) {
+	    uip_connr->rtoclk <<= 1;
+	    if(uip_connr->rtoclk > RTO_MAX) {
+	      uip_connr->rtoclk = RTO_MAX;
+	    }
+	  }
+	  uip_connr->rtt_seq = 0;
+	  rexmit_set(uip_connr, uip_connr->rtoclk);
+#else /* UIP_TCP_CLOCK_RTO */
 	  uip_connr->timer = UIP_RTO << (uip_connr->nrtx > 4?
 					 4:
 					 uip_connr->nrtx);
+#endif /* UIP_TCP_CLOCK_RTO */
 	  ++(uip_connr->nrtx);
 	  
 	  /* Ok, so we need to retransmit. We do this differently
@@ -786,6 +2347,19 @@ uip_process(u8_t flag)
                to do the actual retransmit after which we jump into
                the code for sending out the packet (the apprexmit
                label). */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+	    /* Only the oldest segment in flight is retransmitted. */
+	    uip_rexmit_off = 0;
+	    uip_rexmit_len = uip_connr->seglen[0];
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+#if UIP_TCP_CC
+	    uip_cc_timeout(uip_connr);
+#if UIP_TCP_SACK
+	    /* The SACK information of the remote host is not trusted
+	       after a timeout (RFC 2018, section 8). */
+	    uip_connr->sacked = uip_connr->rtxed = 0;
+#endif /* UIP_TCP_SACK */
+#endif /* UIP_TCP_CC */
 	    uip_flags = UIP_REXMIT;
 	    UIP_APPCALL();
 	    goto apprexmit;
@@ -798,7 +2372,8 @@ uip_process(u8_t flag)
 	    
 	  }
 	}
-      } else if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+      }
+      if(CAN_POLL(uip_connr)) {
 	/* If there was no need for a retransmission, we poll the
            application for new data. */
 	uip_flags = UIP_POLL;
@@ -807,7 +2382,56 @@ uip_process(u8_t flag)
       }
     }
     goto drop;
+#if UIP_TCP_CLOCK_RTO
+  } else if(flag == UIP_REXMIT_TIMER) {
+    uip_len = 0;
+    uip_slen = 0;
+#if UIP_TCP_DELAYED_ACK
+    if(uip_connr->delack != 0) {
+      /* The timer is kept armed in case a retransmission is sent
+	 first and the application sends no data. */
+      rexmit_arm(timer_remaining(&uip_connr->at));
+    }
+#endif /* UIP_TCP_DELAYED_ACK */
+    if(uip_connr->tcpstateflags != UIP_CLOSED &&
+       uip_connr->tcpstateflags != UIP_TIME_WAIT &&
+       uip_connr->tcpstateflags != UIP_FIN_WAIT_2 &&
+       uip_outstanding(uip_connr)) {
+      if(timer_expired(&uip_connr->rt)) {
+	goto rexmit;
+      }
+      rexmit_set(uip_connr, timer_remaining(&uip_connr->rt));
+    }
+#if UIP_TCP_DELAYED_ACK
+    if(uip_connr->delack != 0 && timer_expired(&uip_connr->at) &&
+       (uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+      /* The delayed acknowledgment is due. */
+      uip_connr->delack = 0;
+      goto tcp_send_ack;
+    }
+#endif /* UIP_TCP_DELAYED_ACK */
+    goto drop;
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_TCP_REORDER
+  } else if(flag == UIP_REORDER) {
+    uip_len = 0;
+    uip_slen = 0;
+    if(!uip_reorder_ready(uip_connr)) {
+      goto drop;
+    }
+    /* The first queued segment is processed as if it had just been
+       received. Its acknowledgment number is out of date, so the ACK
+       flag is cleared. */
+    ooq_deliver(uip_connr);
+    BUF->flags &= ~TCP_ACK;
+    UIP_STAT(++uip_stat.tcp.oomerged);
+    goto found;
+#endif /* UIP_TCP_REORDER */
   }
+  /* From here on, uip_connr is only set once a TCP segment has been
+     matched to a connection. */
+  uip_connr = NULL;
+
 #if UIP_UDP
   if(flag == UIP_UDP_TIMER) {
     if(uip_udp_conn->lport != 0) {
@@ -1157,6 +2781,12 @@ uip_process(u8_t flag)
   uip_ipaddr_copy(BUF->destipaddr, uip_udp_conn->ripaddr);
    
   uip_appdata = &uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN];
+#if UIP_ZEROCOPY
+  if(sendref != NULL) {
+    uip_appdata = (void *)sendref;
+    uip_reflen = uip_slen;
+  }
+#endif /* UIP_ZEROCOPY */
 
 #if UIP_UDP_CHECKSUMS
   /* Calculate UDP checksum. */
@@ -1185,7 +2815,29 @@ uip_process(u8_t flag)
   
   
   /* Demultiplex this segment. */
+#if UIP_TCP_FASTPATH
+  /* Segments tend to arrive in trains for the same connection, so
+     the connection that received the last segment is tried first. */
+  uip_connr = lastconn;
+  if(uip_connr->tcpstateflags != UIP_CLOSED &&
+     BUF->destport == uip_connr->lport &&
+     BUF->srcport == uip_connr->rport &&
+     uip_ipaddr_cmp(BUF->srcipaddr, uip_connr->ripaddr)) {
+    goto found;
+  }
+#endif /* UIP_TCP_FASTPATH */
   /* First check any active connections. */
+#if UIP_TCP_HASH
+  for(uip_connr = *conn_bucket(BUF->destport, BUF->srcport,
+				 (u8_t *)BUF->srcipaddr);
+      uip_connr != NULL; uip_connr = uip_connr->hnext) {
+    if(BUF->destport == uip_connr->lport &&
+       BUF->srcport == uip_connr->rport &&
+       uip_ipaddr_cmp(BUF->srcipaddr, uip_connr->ripaddr)) {
+      goto found;
+    }
+  }
+#else /* UIP_TCP_HASH */
   for(uip_connr = &uip_conns[0]; uip_connr <= &uip_conns[UIP_CONNS - 1];
       ++uip_connr) {
     if(uip_connr->tcpstateflags != UIP_CLOSED &&
@@ -1195,22 +2847,103 @@ uip_process(u8_t flag)
       goto found;
     }
   }
+#endif /* UIP_TCP_HASH */
+  /* The segment is not for a connection, so no connection is to be
+     looked at when the packet is dropped or answered with a RST. */
+  uip_connr = NULL;
+
+#if UIP_TCP_TIME_WAIT_CONNS
+  /* Then the connections in TIME_WAIT. */
+  {
+    register struct tw_entry *tw;
+
+    for(tw = &tw_conns[0]; tw <= &tw_conns[UIP_TCP_TIME_WAIT_CONNS - 1];
+	++tw) {
+      if(tw->lport != 0 &&
+	 BUF->destport == tw->lport &&
+	 BUF->srcport == tw->rport &&
+	 uip_ipaddr_cmp(BUF->srcipaddr, tw->ripaddr)) {
+	if(BUF->flags & TCP_RST) {
+	  tw->lport = 0;
+	  goto drop;
+	}
+	if((BUF->flags & TCP_CTL) == TCP_SYN &&
+	   ((SEQ_GET(BUF->seqno) - CONN_SEQ(tw->rcv_nxt) - 1) &
+	    0xffffffffUL) < 0x7fffffffUL) {
+	  /* A SYN beyond the end of the old connection opens a new
+	     one (RFC 1122, 4.2.2.13). */
+	  tw->lport = 0;
+	  break;
+	}
+	/* Anything else is answered with an acknowledgment, like in
+	   the TIME_WAIT state of a connection. */
+	BUF->flags = TCP_ACK;
+	SEQ_STORE(BUF->seqno, tw->snd_nxt);
+	SEQ_STORE(BUF->ackno, tw->rcv_nxt);
+	BUF->srcport = tw->lport;
+	BUF->destport = tw->rport;
+	uip_ipaddr_copy(BUF->destipaddr, tw->ripaddr);
+	uip_ipaddr_copy(BUF->srcipaddr, uip_hostaddr);
+	uip_len = UIP_IPTCPH_LEN;
+	BUF->tcpoffset = 5 << 4;
+#if UIP_TCP_WINDOW_SCALE || UIP_PACKETS
+	rcv_window(NULL);
+#else /* UIP_TCP_WINDOW_SCALE || UIP_PACKETS */
+	BUF->wnd[0] = ((UIP_RECEIVE_WINDOW) >> 8);
+	BUF->wnd[1] = ((UIP_RECEIVE_WINDOW) & 0xff);
+#endif /* UIP_TCP_WINDOW_SCALE || UIP_PACKETS */
+	uip_connr = NULL;
+	goto tcp_send_noconn;
+      }
+    }
+  }
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
 
   /* If we didn't find and active connection that expected the packet,
      either this packet is an old duplicate, or this is a SYN packet
      destined for a connection in LISTEN. If the SYN flag isn't set,
      it is an old packet and we send a RST. */
+#if UIP_TCP_SYNCOOKIES
+  /* An acknowledgment may also complete a connection that was
+     answered with a SYN cookie. */
+  if((BUF->flags & TCP_CTL) != TCP_SYN &&
+     (BUF->flags & (TCP_CTL & ~TCP_PSH)) != TCP_ACK) {
+    goto reset;
+  }
+#else /* UIP_TCP_SYNCOOKIES */
   if((BUF->flags & TCP_CTL) != TCP_SYN) {
     goto reset;
   }
+#endif /* UIP_TCP_SYNCOOKIES */
   
   tmp16 = BUF->destport;
   /* Next, check listening connections. */
-  for(c = 0; c < UIP_LISTENPORTS; ++c) {
-    if(tmp16 == uip_listenports[c])
-      goto found_listen;
+#if UIP_TCP_HASH
+  {
+    u16_t i;
+    for(i = listen_hash[LISTEN_HASH(tmp16)]; i != 0; i = listen_next[i - 1]) {
+      if(tmp16 == uip_listenports[i - 1]) {
+	goto found_listen;
+      }
+    }
   }
+#else /* UIP_TCP_HASH */
+  {
+    u16_t *p;
+    for(p = &uip_listenports[0];
+	p <= &uip_listenports[UIP_LISTENPORTS - 1]; ++p) {
+      if(tmp16 == *p) {
+	goto found_listen;
+      }
+    }
+  }
+#endif /* UIP_TCP_HASH */
   
+#if UIP_TCP_SYNCOOKIES
+  if(!(BUF->flags & TCP_SYN)) {
+    goto reset;
+  }
+#endif /* UIP_TCP_SYNCOOKIES */
   /* No matching connection found, so we send a RST packet. */
   UIP_STAT(++uip_stat.tcp.synrst);
  reset:
@@ -1226,6 +2959,20 @@ uip_process(u8_t flag)
   uip_len = UIP_IPTCPH_LEN;
   BUF->tcpoffset = 5 << 4;
 
+#if UIP_TCP_SYNCOOKIES
+ tcp_send_reply:
+#endif /* UIP_TCP_SYNCOOKIES */
+#if UIP_TCP_SEQ32
+  /* Flip the seqno and ackno fields in the TCP header, and increase
+     the sequence number we are acknowledging. */
+  {
+    u32_t seq;
+
+    seq = SEQ_GET(BUF->seqno) + 1;
+    memcpy(BUF->seqno, BUF->ackno, 4);
+    SEQ_PUT(BUF->ackno, seq);
+  }
+#else /* UIP_TCP_SEQ32 */
   /* Flip the seqno and ackno fields in the TCP header. */
   c = BUF->seqno[3];
   BUF->seqno[3] = BUF->ackno[3];
@@ -1253,6 +3000,7 @@ uip_process(u8_t flag)
       }
     }
   }
+#endif /* UIP_TCP_SEQ32 */
  
   /* Swap port numbers. */
   tmp16 = BUF->srcport;
@@ -1270,6 +3018,34 @@ uip_process(u8_t flag)
      with a connection in LISTEN. In that case, we should create a new
      connection and send a SYNACK in return. */
  found_listen:
+#if UIP_TCP_SYNCOOKIES
+  if(!(BUF->flags & TCP_SYN)) {
+    /* An acknowledgment for a listening port must return a valid SYN
+       cookie. */
+    tmp16 = cookie_check();
+    if(tmp16 == 0) {
+      UIP_STAT(++uip_stat.tcp.cookiebad);
+      goto reset;
+    }
+  }
+#endif /* UIP_TCP_SYNCOOKIES */
+#if UIP_TCP_SYN_BACKLOG
+  if(BUF->flags & TCP_SYN) {
+    /* Count the half-open connections of the listening port. */
+    register struct uip_conn *cconn;
+    c = 0;
+    for(cconn = &uip_conns[0]; cconn <= &uip_conns[UIP_CONNS - 1]; ++cconn) {
+      if((cconn->tcpstateflags & UIP_TS_MASK) == UIP_SYN_RCVD &&
+	 cconn->lport == BUF->destport) {
+	++c;
+      }
+    }
+    if(c >= UIP_TCP_SYN_BACKLOG) {
+      goto syn_full;
+    }
+  }
+#endif /* UIP_TCP_SYN_BACKLOG */
+
   /* First we check if there are any connections avaliable. Unused
      connections are kept in the same table as used connections, but
      unused ones have the tcpstate set to CLOSED. Also, connections in
@@ -1277,20 +3053,67 @@ uip_process(u8_t flag)
      CLOSED connections are found. Thanks to Eddie C. Dost for a very
      nice algorithm for the TIME_WAIT search. */
   uip_connr = 0;
-  for(c = 0; c < UIP_CONNS; ++c) {
-    if(uip_conns[c].tcpstateflags == UIP_CLOSED) {
-      uip_connr = &uip_conns[c];
-      break;
-    }
-    if(uip_conns[c].tcpstateflags == UIP_TIME_WAIT) {
-      if(uip_connr == 0 ||
-	 uip_conns[c].timer > uip_connr->timer) {
-	uip_connr = &uip_conns[c];
+  {
+    register struct uip_conn *cconn;
+    for(cconn = &uip_conns[0]; cconn <= &uip_conns[UIP_CONNS - 1]; ++cconn) {
+      if(cconn->tcpstateflags == UIP_CLOSED) {
+	uip_connr = cconn;
+	break;
+      }
+      if(cconn->tcpstateflags == UIP_TIME_WAIT) {
+#if UIP_TCP_TIMER_WHEEL
+	wheel_sync(cconn, uip_ticks);
+#endif /* UIP_TCP_TIMER_WHEEL */
+	if(uip_connr == 0 ||
+	   cconn->timer > uip_connr->timer) {
+	  uip_connr = cconn;
+	}
       }
     }
   }
+#if UIP_DYNAMIC_TABLES
+  if((uip_connr == 0 || uip_connr->tcpstateflags != UIP_CLOSED) &&
+     uip_conns_used < conns_max) {
+    /* Use a new entry rather than one in TIME_WAIT. */
+    uip_connr = &uip_conns[uip_conns_used++];
+  }
+#endif /* UIP_DYNAMIC_TABLES */
 
   if(uip_connr == 0) {
+#if UIP_TCP_SYN_BACKLOG
+  syn_full:
+#endif /* UIP_TCP_SYN_BACKLOG */
+#if UIP_TCP_SYNCOOKIES
+    if(BUF->flags & TCP_SYN) {
+      /* Answer with a SYN cookie instead. Like a RST, the SYNACK is
+	 made from the SYN in place: our initial sequence number is put
+	 in the ackno field before the sequence numbers are flipped. */
+      UIP_STAT(++uip_stat.tcp.cookiesent);
+      {
+	unsigned long isn;
+
+	isn = SEQ_GET(BUF->seqno) + cookie_make();
+	SEQ_PUT(BUF->ackno, isn);
+      }
+      BUF->flags = TCP_SYN | TCP_ACK;
+      BUF->optdata[0] = TCP_OPT_MSS;
+      BUF->optdata[1] = TCP_OPT_MSS_LEN;
+      BUF->optdata[2] = (UIP_TCP_MSS) / 256;
+      BUF->optdata[3] = (UIP_TCP_MSS) & 255;
+      uip_len = UIP_IPTCPH_LEN + TCP_OPT_MSS_LEN;
+      BUF->tcpoffset = ((UIP_TCPH_LEN + TCP_OPT_MSS_LEN) / 4) << 4;
+#if UIP_TCP_WINDOW_SCALE || UIP_PACKETS
+      /* The window of a SYN segment does not depend on the
+	 connection. */
+      rcv_window(NULL);
+#else /* UIP_TCP_WINDOW_SCALE || UIP_PACKETS */
+      BUF->wnd[0] = ((UIP_RECEIVE_WINDOW) >> 8);
+      BUF->wnd[1] = ((UIP_RECEIVE_WINDOW) & 0xff);
+#endif /* UIP_TCP_WINDOW_SCALE || UIP_PACKETS */
+      uip_connr = NULL;
+      goto tcp_send_reply;
+    }
+#endif /* UIP_TCP_SYNCOOKIES */
     /* All connections are used already, we drop packet and hope that
        the remote end will retransmit the packet at a time when we
        have more spare connections. */
@@ -1299,62 +3122,89 @@ uip_process(u8_t flag)
     goto drop;
   }
   uip_conn = uip_connr;
+#if UIP_TCP_HASH
+  if(uip_connr->tcpstateflags != UIP_CLOSED) {
+    /* We are reusing a connection in TIME_WAIT. */
+    conn_unhash(uip_connr);
+  }
+#endif /* UIP_TCP_HASH */
+#if UIP_EPHEMERAL_PORTS
+  PORT_RELEASE(uip_connr);
+#endif /* UIP_EPHEMERAL_PORTS */
+#if UIP_TCP_REORDER
+  ooq_free(uip_connr);
+#endif /* UIP_TCP_REORDER */
   
   /* Fill in the necessary fields for the new connection. */
   uip_connr->rto = uip_connr->timer = UIP_RTO;
+#if UIP_TCP_TIMER_WHEEL
+  uip_connr->tick = uip_ticks;
+#endif /* UIP_TCP_TIMER_WHEEL */
   uip_connr->sa = 0;
   uip_connr->sv = 4;
   uip_connr->nrtx = 0;
+#if UIP_TCP_DELAYED_ACK
+  uip_connr->delack = 0;
+#endif /* UIP_TCP_DELAYED_ACK */
+#if UIP_TCP_CLOCK_RTO
+  uip_connr->srtt = uip_connr->rttvar = 0;
+  uip_connr->rtoclk = RTO_INIT;
+  uip_connr->rtt_seq = 0;
+  rtt_start(uip_connr, 1);
+  rexmit_set(uip_connr, uip_connr->rtoclk);
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+  uip_connr->nseg = 0;
+  uip_connr->snd_wnd = snd_window(uip_connr);
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
   uip_connr->lport = BUF->destport;
   uip_connr->rport = BUF->srcport;
   uip_ipaddr_copy(uip_connr->ripaddr, BUF->srcipaddr);
   uip_connr->tcpstateflags = UIP_SYN_RCVD;
+#if UIP_TCP_HASH
+  conn_hash_insert(uip_connr);
+#endif /* UIP_TCP_HASH */
+
+#if UIP_TCP_SYNCOOKIES
+  if(!(BUF->flags & TCP_SYN)) {
+    /* The connection is created from the SYN cookie as if we had
+       been in SYN_RCVD all along, and the acknowledgment is then
+       processed as usual. */
+    UIP_STAT(++uip_stat.tcp.cookierecv);
+#if UIP_TCP_SEQ32
+    uip_connr->snd_nxt = SEQ_GET(BUF->ackno) - 1;
+#else /* UIP_TCP_SEQ32 */
+    SEQ_PUT(uip_connr->snd_nxt, SEQ_GET(BUF->ackno) - 1);
+#endif /* UIP_TCP_SEQ32 */
+    uip_connr->len = 1;
+    SEQ_LOAD(uip_connr->rcv_nxt, BUF->seqno);
+    uip_connr->initialmss = uip_connr->mss =
+      tmp16 > UIP_TCP_MSS? UIP_TCP_MSS: tmp16;
+    tcp_options(uip_connr);
+#if UIP_TCP_CLOCK_RTO
+    /* We do not know when the SYNACK was sent. */
+    uip_connr->rtt_seq = 0;
+#endif /* UIP_TCP_CLOCK_RTO */
+    goto found;
+  }
+#endif /* UIP_TCP_SYNCOOKIES */
 
+#if UIP_TCP_SEQ32
+  uip_connr->snd_nxt = iss;
+#else /* UIP_TCP_SEQ32 */
   uip_connr->snd_nxt[0] = iss[0];
   uip_connr->snd_nxt[1] = iss[1];
   uip_connr->snd_nxt[2] = iss[2];
   uip_connr->snd_nxt[3] = iss[3];
+#endif /* UIP_TCP_SEQ32 */
   uip_connr->len = 1;
 
   /* rcv_nxt should be the seqno from the incoming packet + 1. */
-  uip_connr->rcv_nxt[3] = BUF->seqno[3];
-  uip_connr->rcv_nxt[2] = BUF->seqno[2];
-  uip_connr->rcv_nxt[1] = BUF->seqno[1];
-  uip_connr->rcv_nxt[0] = BUF->seqno[0];
+  SEQ_LOAD(uip_connr->rcv_nxt, BUF->seqno);
   uip_add_rcv_nxt(1);
 
-  /* Parse the TCP MSS option, if present. */
-  if((BUF->tcpoffset & 0xf0) > 0x50) {
-    for(c = 0; c < ((BUF->tcpoffset >> 4) - 5) << 2 ;) {
-      opt = uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + c];
-      if(opt == TCP_OPT_END) {
-	/* End of options. */
-	break;
-      } else if(opt == TCP_OPT_NOOP) {
-	++c;
-	/* NOP option. */
-      } else if(opt == TCP_OPT_MSS &&
-		uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c] == TCP_OPT_MSS_LEN) {
-	/* An MSS option with the right option length. */
-	tmp16 = ((u16_t)uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 2 + c] << 8) |
-	  (u16_t)uip_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN + 3 + c];
-	uip_connr->initialmss = uip_connr->mss =
-	  tmp16 > UIP_TCP_MSS? UIP_TCP_MSS: tmp16;
-	
-	/* And we are done processing options. */
-	break;
-      } else {
-	/* All other options have a length field, so that we easily
-	   can skip past them. */
-	if(uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c] == 0) {
-	  /* If the length field is zero, the options are malformed
-	     and we don't process them further. */
-	  break;
-	}
-	c += uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c];
-      }
-    }
-  }
+  /* Parse the TCP options. */
+  tcp_options(uip_connr);
   
   /* Our response will be a SYNACK. */
 #if UIP_ACTIVE_OPEN
@@ -1375,19 +3225,46 @@ uip_process(u8_t flag)
   BUF->optdata[2] = (UIP_TCP_MSS) / 256;
   BUF->optdata[3] = (UIP_TCP_MSS) & 255;
   uip_len = UIP_IPTCPH_LEN + TCP_OPT_MSS_LEN;
-  BUF->tcpoffset = ((UIP_TCPH_LEN + TCP_OPT_MSS_LEN) / 4) << 4;
+#if UIP_TCP_WINDOW_SCALE
+  /* The window scale option is sent with our SYN, and with our SYNACK
+     if the remote host sent it in its SYN. */
+  if(uip_connr->rcv_wscale != 0) {
+    uip_buf[UIP_LLH_LEN + uip_len] = TCP_OPT_NOOP;
+    uip_buf[UIP_LLH_LEN + uip_len + 1] = TCP_OPT_WS;
+    uip_buf[UIP_LLH_LEN + uip_len + 2] = TCP_OPT_WS_LEN;
+    uip_buf[UIP_LLH_LEN + uip_len + 3] = uip_connr->rcv_wscale;
+    uip_len += 4;
+  }
+#endif /* UIP_TCP_WINDOW_SCALE */
+#if UIP_TCP_SACK
+  /* The same goes for the SACK-permitted option. */
+  if(uip_connr->sackok) {
+    uip_buf[UIP_LLH_LEN + uip_len] = TCP_OPT_NOOP;
+    uip_buf[UIP_LLH_LEN + uip_len + 1] = TCP_OPT_NOOP;
+    uip_buf[UIP_LLH_LEN + uip_len + 2] = TCP_OPT_SACK_PERM;
+    uip_buf[UIP_LLH_LEN + uip_len + 3] = TCP_OPT_SACK_PERM_LEN;
+    uip_len += 4;
+  }
+#endif /* UIP_TCP_SACK */
+  BUF->tcpoffset = ((uip_len - UIP_IPH_LEN) / 4) << 4;
   goto tcp_send;
 
   /* This label will be jumped to if we found an active connection. */
  found:
   uip_conn = uip_connr;
   uip_flags = 0;
+#if UIP_TCP_FASTPATH
+  lastconn = uip_connr;
+#endif /* UIP_TCP_FASTPATH */
+#if UIP_TCP_TIMER_WHEEL
+  wheel_sync(uip_connr, uip_ticks);
+#endif /* UIP_TCP_TIMER_WHEEL */
   /* We do a very naive form of TCP reset processing; we just accept
      any RST and kill our connection. We should in fact check if the
      sequence number of this reset is wihtin our advertised window
      before we accept the reset. */
   if(BUF->flags & TCP_RST) {
-    uip_connr->tcpstateflags = UIP_CLOSED;
+    SET_CLOSED(uip_connr);
     UIP_LOG("tcp: got reset, aborting connection.");
     uip_flags = UIP_ABORT;
     UIP_APPCALL();
@@ -1401,16 +3278,56 @@ uip_process(u8_t flag)
      c) and the length of the IP header (20 bytes). */
   uip_len = uip_len - c - UIP_IPH_LEN;
 
+#if UIP_TCP_FASTPATH
+  /* Header prediction: on an established connection, the next
+     segment is most likely either in-order data that acknowledges
+     nothing new, or a pure acknowledgment of outstanding data. Such
+     segments carry no options and no flags other than ACK and PSH.
+     Both skip the sequence number check, and in-order data also
+     skips the acknowledgment processing and the connection state
+     switch. */
+  if(uip_connr->tcpstateflags == UIP_ESTABLISHED &&
+     (BUF->flags & (TCP_CTL & ~TCP_PSH)) == TCP_ACK &&
+     c == UIP_TCPH_LEN &&
+     SEQ_EQ(BUF->seqno, uip_connr->rcv_nxt)) {
+    if(uip_len > 0) {
+      if(SEQ_EQ(BUF->ackno, uip_connr->snd_nxt)) {
+	/* In-order data for us. Nothing is acknowledged, so we go
+	   straight to handing the data to the application. */
+	UIP_STAT(++uip_stat.tcp.predicted);
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+	uip_connr->snd_wnd = snd_window(uip_connr);
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+#if UIP_URGDATA > 0
+	uip_urglen = 0;
+#endif /* UIP_URGDATA > 0 */
+	goto predicted_data;
+      }
+    } else if(uip_outstanding(uip_connr)) {
+      /* An acknowledgment for data that we have sent. */
+      UIP_STAT(++uip_stat.tcp.predicted);
+      goto predicted_ack;
+    }
+  }
+#endif /* UIP_TCP_FASTPATH */
+
   /* First, check if the sequence number of the incoming packet is
      what we're expecting next. If not, we send out an ACK with the
      correct numbers in. */
   if(!(((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_SYN_SENT) &&
        ((BUF->flags & TCP_CTL) == (TCP_SYN | TCP_ACK)))) {
     if((uip_len > 0 || ((BUF->flags & (TCP_SYN | TCP_FIN)) != 0)) &&
-       (BUF->seqno[0] != uip_connr->rcv_nxt[0] ||
-	BUF->seqno[1] != uip_connr->rcv_nxt[1] ||
-	BUF->seqno[2] != uip_connr->rcv_nxt[2] ||
-	BUF->seqno[3] != uip_connr->rcv_nxt[3])) {
+       !SEQ_EQ(BUF->seqno, uip_connr->rcv_nxt)) {
+#if UIP_TCP_REORDER
+      /* Data that arrives ahead of a missing segment is queued until
+	 the missing segment has been received. */
+      if(uip_len > 0 && (BUF->flags & TCP_SYN) == 0 &&
+	 ((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED ||
+	  (uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_FIN_WAIT_1 ||
+	  (uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_FIN_WAIT_2)) {
+	ooq_insert(uip_connr, c);
+      }
+#endif /* UIP_TCP_REORDER */
       goto tcp_send_ack;
     }
   }
@@ -1419,9 +3336,62 @@ uip_process(u8_t flag)
      data. If so, we update the sequence number, reset the length of
      the outstanding data, calculate RTT estimations, and reset the
      retransmission timer. */
+#if UIP_TCP_FASTPATH
+ predicted_ack:
+#endif /* UIP_TCP_FASTPATH */
   if((BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+    /* Find out how many of the data segments in flight that the
+       incoming segment acknowledges. An acknowledgment that falls
+       inside a segment is ignored, and the segment will eventually be
+       retransmitted in full. If there are no data segments in flight,
+       the outstanding data is our SYN or FIN. */
+#if UIP_TCP_SACK && UIP_TCP_CC
+    if(uip_connr->sackok && uip_connr->nseg > 0 &&
+       (BUF->tcpoffset & 0xf0) > 0x50) {
+      sack_input(uip_connr);
+    }
+#endif /* UIP_TCP_SACK && UIP_TCP_CC */
+#if UIP_TCP_SEQ32
+    acked = SEQ_GET(BUF->ackno) - uip_connr->snd_nxt;
+#endif /* UIP_TCP_SEQ32 */
+    tmp16 = 0;
+    for(c = 0; c < uip_connr->nseg; ++c) {
+      tmp16 += uip_connr->seglen[c];
+#if UIP_TCP_SEQ32
+      if(acked == tmp16) {
+	break;
+      }
+#else /* UIP_TCP_SEQ32 */
+      uip_add32(uip_connr->snd_nxt, tmp16);
+      if(BUF->ackno[0] == uip_acc32[0] &&
+	 BUF->ackno[1] == uip_acc32[1] &&
+	 BUF->ackno[2] == uip_acc32[2] &&
+	 BUF->ackno[3] == uip_acc32[3]) {
+	break;
+      }
+#endif /* UIP_TCP_SEQ32 */
+    }
+    if(uip_connr->nseg == 0) {
+      tmp16 = uip_connr->len;
+#if !UIP_TCP_SEQ32
+      uip_add32(uip_connr->snd_nxt, tmp16);
+#endif /* !UIP_TCP_SEQ32 */
+    }
+#else /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+#if UIP_TCP_SEQ32
+    acked = SEQ_GET(BUF->ackno) - uip_connr->snd_nxt;
+    tmp16 = uip_connr->len;
+#else /* UIP_TCP_SEQ32 */
     uip_add32(uip_connr->snd_nxt, uip_connr->len);
+#endif /* UIP_TCP_SEQ32 */
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
 
+#if UIP_TCP_SEQ32
+    if(acked == tmp16) {
+      /* Update sequence number. */
+      uip_connr->snd_nxt += tmp16;
+#else /* UIP_TCP_SEQ32 */
     if(BUF->ackno[0] == uip_acc32[0] &&
        BUF->ackno[1] == uip_acc32[1] &&
        BUF->ackno[2] == uip_acc32[2] &&
@@ -1431,8 +3401,22 @@ uip_process(u8_t flag)
       uip_connr->snd_nxt[1] = uip_acc32[1];
       uip_connr->snd_nxt[2] = uip_acc32[2];
       uip_connr->snd_nxt[3] = uip_acc32[3];
+#endif /* UIP_TCP_SEQ32 */
 	
 
+#if UIP_TCP_CLOCK_RTO
+      /* Measure the round-trip time if the timed segment has been
+	 acknowledged. */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+      if(uip_connr->rtt_seq > tmp16) {
+	uip_connr->rtt_seq -= tmp16;
+      } else
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+      if(uip_connr->rtt_seq != 0) {
+	rtt_update(uip_connr, clock_time() - uip_connr->rtt_start);
+	uip_connr->rtt_seq = 0;
+      }
+#else /* UIP_TCP_CLOCK_RTO */
       /* Do RTT estimation, unless we have done retransmissions. */
       if(uip_connr->nrtx == 0) {
 	signed char m;
@@ -1448,17 +3432,104 @@ uip_process(u8_t flag)
 	uip_connr->rto = (uip_connr->sa >> 3) + uip_connr->sv;
 
       }
+#endif /* UIP_TCP_CLOCK_RTO */
       /* Set the acknowledged flag. */
       uip_flags = UIP_ACKDATA;
       /* Reset the retransmission timer. */
       uip_connr->timer = uip_connr->rto;
 
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+      uip_connr->len -= tmp16;
+      uip_acklen = tmp16;
+      uip_connr->nrtx = 0;
+
+      /* Remove the acknowledged segments from the queue. */
+      if(uip_connr->nseg > 0) {
+	++c;
+	uip_connr->nseg -= c;
+	for(opt = 0; opt < uip_connr->nseg; ++opt) {
+	  uip_connr->seglen[opt] = uip_connr->seglen[opt + c];
+	}
+#if UIP_TCP_SACK && UIP_TCP_CC
+	uip_connr->sacked >>= c;
+	uip_connr->rtxed >>= c;
+#endif /* UIP_TCP_SACK && UIP_TCP_CC */
+#if UIP_TCP_CC
+	if(uip_cc_ack(uip_connr, tmp16)) {
+	  /* A partial acknowledgment during loss recovery; the
+	     application is asked to retransmit the oldest segment
+	     while it is told about the acknowledged data. */
+#if UIP_TCP_SACK
+	  /* With SACK, segments that have already been retransmitted
+	     or that the remote host holds are skipped. */
+	  if(sack_hole(uip_connr)) {
+	    uip_flags |= UIP_REXMIT;
+	  }
+#else /* UIP_TCP_SACK */
+	  uip_rexmit_off = 0;
+	  uip_rexmit_len = uip_connr->seglen[0];
+	  uip_flags |= UIP_REXMIT;
+#endif /* UIP_TCP_SACK */
+#if UIP_TCP_CLOCK_RTO
+	  uip_connr->rtt_seq = 0;
+#endif /* UIP_TCP_CLOCK_RTO */
+	}
+#endif /* UIP_TCP_CC */
+      }
+#else /* UIP_TCP_WINDOW_SEGMENTS > 1 */
       /* Reset length of outstanding data. */
       uip_connr->len = 0;
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+#if UIP_TCP_CLOCK_RTO
+      if(uip_outstanding(uip_connr)) {
+	rexmit_set(uip_connr, uip_connr->rtoclk);
+      }
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_TCP_CC
+    } else if(uip_connr->nseg > 0 && uip_len == 0 &&
+	      (BUF->flags & (TCP_SYN | TCP_FIN)) == 0 &&
+	      SEQ_EQ(BUF->ackno, uip_connr->snd_nxt) &&
+	      snd_window(uip_connr) == uip_connr->snd_wnd) {
+      /* A duplicate acknowledgment: the segment that follows the
+	 acknowledged data is missing at the remote host. After three
+	 of these, we retransmit it without waiting for the timer. */
+      if(uip_cc_dupack(uip_connr)) {
+	uip_rexmit_off = 0;
+	uip_rexmit_len = uip_connr->seglen[0];
+	uip_flags = UIP_REXMIT;
+#if UIP_TCP_SACK
+	uip_connr->rtxed = 1;
+#endif /* UIP_TCP_SACK */
+#if UIP_TCP_CLOCK_RTO
+	uip_connr->rtt_seq = 0;
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_TCP_SACK
+      } else if(uip_connr->recovery && sack_hole(uip_connr)) {
+	/* During loss recovery, each further duplicate acknowledgment
+	   lets us retransmit the next segment that the SACK blocks
+	   show to be missing. */
+	uip_flags = UIP_REXMIT;
+#if UIP_TCP_CLOCK_RTO
+	uip_connr->rtt_seq = 0;
+#endif /* UIP_TCP_CLOCK_RTO */
+#endif /* UIP_TCP_SACK */
+      } else if(CAN_POLL(uip_connr)) {
+	/* The duplicate acknowledgment may have opened up the
+	   window, so we ask the application for new data. */
+	uip_flags = UIP_POLL;
+      }
+#endif /* UIP_TCP_CC */
     }
     
   }
 
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+  /* Remember the window advertised by the remote host. */
+  if(BUF->flags & TCP_ACK) {
+    uip_connr->snd_wnd = snd_window(uip_connr);
+  }
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+
   /* Do different things depending on in what state the connection is. */
   switch(uip_connr->tcpstateflags & UIP_TS_MASK) {
     /* CLOSED and LISTEN are not handled here. CLOSE_WAIT is not
@@ -1474,6 +3545,9 @@ uip_process(u8_t flag)
       uip_connr->tcpstateflags = UIP_ESTABLISHED;
       uip_flags = UIP_CONNECTED;
       uip_connr->len = 0;
+#if UIP_TCP_CC
+      uip_cc_init(uip_connr);
+#endif /* UIP_TCP_CC */
       if(uip_len > 0) {
         uip_flags |= UIP_NEWDATA;
         uip_add_rcv_nxt(uip_len);
@@ -1492,46 +3566,16 @@ uip_process(u8_t flag)
     if((uip_flags & UIP_ACKDATA) &&
        (BUF->flags & TCP_CTL) == (TCP_SYN | TCP_ACK)) {
 
-      /* Parse the TCP MSS option, if present. */
-      if((BUF->tcpoffset & 0xf0) > 0x50) {
-	for(c = 0; c < ((BUF->tcpoffset >> 4) - 5) << 2 ;) {
-	  opt = uip_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN + c];
-	  if(opt == TCP_OPT_END) {
-	    /* End of options. */
-	    break;
-	  } else if(opt == TCP_OPT_NOOP) {
-	    ++c;
-	    /* NOP option. */
-	  } else if(opt == TCP_OPT_MSS &&
-		    uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c] == TCP_OPT_MSS_LEN) {
-	    /* An MSS option with the right option length. */
-	    tmp16 = (uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 2 + c] << 8) |
-	      uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 3 + c];
-	    uip_connr->initialmss =
-	      uip_connr->mss = tmp16 > UIP_TCP_MSS? UIP_TCP_MSS: tmp16;
-
-	    /* And we are done processing options. */
-	    break;
-	  } else {
-	    /* All other options have a length field, so that we easily
-	       can skip past them. */
-	    if(uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c] == 0) {
-	      /* If the length field is zero, the options are malformed
-		 and we don't process them further. */
-	      break;
-	    }
-	    c += uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + c];
-	  }
-	}
-      }
+      /* Parse the TCP options. */
+      tcp_options(uip_connr);
       uip_connr->tcpstateflags = UIP_ESTABLISHED;
-      uip_connr->rcv_nxt[0] = BUF->seqno[0];
-      uip_connr->rcv_nxt[1] = BUF->seqno[1];
-      uip_connr->rcv_nxt[2] = BUF->seqno[2];
-      uip_connr->rcv_nxt[3] = BUF->seqno[3];
+      SEQ_LOAD(uip_connr->rcv_nxt, BUF->seqno);
       uip_add_rcv_nxt(1);
       uip_flags = UIP_CONNECTED | UIP_NEWDATA;
       uip_connr->len = 0;
+#if UIP_TCP_CC
+      uip_cc_init(uip_connr);
+#endif /* UIP_TCP_CC */
       uip_len = 0;
       uip_slen = 0;
       UIP_APPCALL();
@@ -1541,7 +3585,7 @@ uip_process(u8_t flag)
     uip_flags = UIP_ABORT;
     UIP_APPCALL();
     /* The connection is closed after we send the RST */
-    uip_conn->tcpstateflags = UIP_CLOSED;
+    SET_CLOSED(uip_conn);
     goto reset;
 #endif /* UIP_ACTIVE_OPEN */
     
@@ -1555,12 +3599,18 @@ uip_process(u8_t flag)
     If the incoming packet is a FIN, we should close the connection on
     this side as well, and we send out a FIN and enter the LAST_ACK
     state. We require that there is no outstanding data; otherwise the
-    sequence numbers will be screwed up. */
+    sequence numbers will be screwed up. The same goes for data that
+    is still in the send buffer of the connection. */
 
     if(BUF->flags & TCP_FIN && !(uip_connr->tcpstateflags & UIP_STOPPED)) {
       if(uip_outstanding(uip_connr)) {
 	goto drop;
       }
+#if UIP_TCP_SENDBUFS
+      if(uip_connr->sendbuf != NULL && uip_connr->sendbuf->len > 0) {
+	goto drop;
+      }
+#endif /* UIP_TCP_SENDBUFS */
       uip_add_rcv_nxt(1 + uip_len);
       uip_flags |= UIP_CLOSE;
       if(uip_len > 0) {
@@ -1601,6 +3651,9 @@ uip_process(u8_t flag)
        we acknowledge. If the application has stopped the dataflow
        using uip_stop(), we must not accept any data packets from the
        remote host. */
+#if UIP_TCP_FASTPATH
+  predicted_data:
+#endif /* UIP_TCP_FASTPATH */
     if(uip_len > 0 && !(uip_connr->tcpstateflags & UIP_STOPPED)) {
       uip_flags |= UIP_NEWDATA;
       uip_add_rcv_nxt(uip_len);
@@ -1619,6 +3672,13 @@ uip_process(u8_t flag)
        "persistent timer" and uses the retransmission mechanim.
     */
     tmp16 = ((u16_t)BUF->wnd[0] << 8) + (u16_t)BUF->wnd[1];
+#if UIP_TCP_WINDOW_SCALE
+    /* The window in a SYN segment is never scaled. */
+    if(!(BUF->flags & TCP_SYN) && uip_connr->snd_wscale > 0) {
+      tmp16 = tmp16 > (0xffff >> uip_connr->snd_wscale)? 0xffff:
+	tmp16 << uip_connr->snd_wscale;
+    }
+#endif /* UIP_TCP_WINDOW_SCALE */
     if(tmp16 > uip_connr->initialmss ||
        tmp16 == 0) {
       tmp16 = uip_connr->initialmss;
@@ -1641,30 +3701,91 @@ uip_process(u8_t flag)
        put into the uip_appdata and the length of the data should be
        put into uip_len. If the application don't have any data to
        send, uip_len must be set to 0. */
+#if UIP_TCP_CC
+    /* With congestion control, the incoming segment may also trigger
+       a retransmission or let the application send more data. */
+    if(uip_flags & (UIP_NEWDATA | UIP_ACKDATA | UIP_REXMIT | UIP_POLL)) {
+#else /* UIP_TCP_CC */
     if(uip_flags & (UIP_NEWDATA | UIP_ACKDATA)) {
+#endif /* UIP_TCP_CC */
       uip_slen = 0;
       UIP_APPCALL();
+#if UIP_TCP_CC
+      if(uip_flags & UIP_REXMIT) {
+	goto apprexmit;
+      }
+#endif /* UIP_TCP_CC */
 
     appsend:
       
       if(uip_flags & UIP_ABORT) {
 	uip_slen = 0;
-	uip_connr->tcpstateflags = UIP_CLOSED;
+	SET_CLOSED(uip_connr);
 	BUF->flags = TCP_RST | TCP_ACK;
 	goto tcp_send_nodata;
       }
 
+#if UIP_TCP_SENDBUFS
+      /* A connection with a send buffer sends the next segment from
+	 the buffer instead of what the application put in
+	 uip_appdata. */
+      if(uip_connr->sendbuf != NULL) {
+	uip_slen = uip_sendbuf_output(uip_connr, uip_sappdata);
+      }
+#endif /* UIP_TCP_SENDBUFS */
+
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+      /* If the application closes the connection while data is in
+	 flight, or sends data together with the close request, the
+	 FIN is held back until all data has been acknowledged. */
+      if(uip_connr->tcpstateflags & UIP_CLOSE_PENDING) {
+	uip_slen = 0;
+	if(!uip_outstanding(uip_connr)) {
+	  uip_flags |= UIP_CLOSE;
+	}
+      } else if((uip_flags & UIP_CLOSE) &&
+		(uip_outstanding(uip_connr) || uip_slen > 0)) {
+	uip_connr->tcpstateflags |= UIP_CLOSE_PENDING;
+	uip_flags &= ~UIP_CLOSE;
+      }
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+
       if(uip_flags & UIP_CLOSE) {
 	uip_slen = 0;
 	uip_connr->len = 1;
 	uip_connr->tcpstateflags = UIP_FIN_WAIT_1;
 	uip_connr->nrtx = 0;
+#if UIP_TCP_CLOCK_RTO
+	rtt_start(uip_connr, 1);
+	rexmit_set(uip_connr, uip_connr->rtoclk);
+#endif /* UIP_TCP_CLOCK_RTO */
 	BUF->flags = TCP_FIN | TCP_ACK;
 	goto tcp_send_nodata;
       }
 
       /* If uip_slen > 0, the application has data to be sent. */
       if(uip_slen > 0) {
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+	/* The new segment follows all data that already is in flight
+	   and must fit within the window of the remote host. */
+	tmp16 = uip_sendroom(uip_connr);
+	if(uip_slen > tmp16) {
+	  uip_slen = tmp16;
+	}
+	if(uip_slen > 0) {
+	  sndoff = uip_connr->len;
+	  uip_connr->seglen[uip_connr->nseg] = uip_slen;
+	  ++uip_connr->nseg;
+	  uip_connr->len += uip_slen;
+#if UIP_TCP_CLOCK_RTO
+	  if(sndoff == 0) {
+	    rexmit_set(uip_connr, uip_connr->rtoclk);
+	  }
+	  rtt_start(uip_connr, uip_connr->len);
+#endif /* UIP_TCP_CLOCK_RTO */
+	}
+      }
+#else /* UIP_TCP_WINDOW_SEGMENTS > 1 */
 
 	/* If the connection has acknowledged data, the contents of
 	   the ->len variable should be discarded. */
@@ -1687,6 +3808,10 @@ uip_process(u8_t flag)
 	  /* Remember how much data we send out now so that we know
 	     when everything has been acknowledged. */
 	  uip_connr->len = uip_slen;
+#if UIP_TCP_CLOCK_RTO
+	  rexmit_set(uip_connr, uip_connr->rtoclk);
+	  rtt_start(uip_connr, uip_connr->len);
+#endif /* UIP_TCP_CLOCK_RTO */
 	} else {
 
 	  /* If the application already had unacknowledged data, we
@@ -1696,11 +3821,34 @@ uip_process(u8_t flag)
 	}
       }
       uip_connr->nrtx = 0;
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
     apprexmit:
+#if UIP_TCP_SENDBUFS
+      if(uip_connr->sendbuf != NULL && (uip_flags & UIP_REXMIT)) {
+	uip_slen = uip_sendbuf_rexmit(uip_connr, uip_sappdata);
+      }
+#endif /* UIP_TCP_SENDBUFS */
       uip_appdata = uip_sappdata;
       
       /* If the application has data to be sent, or if the incoming
          packet had new data in it, we must send out a packet. */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+      if(uip_slen > 0) {
+	if(uip_flags & UIP_REXMIT) {
+	  /* Make sure that we resend exactly the segment that the
+	     application was asked for. */
+	  uip_slen = uip_rexmit_len;
+	  sndoff = uip_rexmit_off;
+	}
+	/* Add the length of the IP and TCP headers. */
+	uip_len = uip_slen + UIP_TCPIP_HLEN;
+	/* We always set the ACK flag in response packets. */
+	BUF->flags = TCP_ACK | TCP_PSH;
+	BUF->tcpoffset = (UIP_TCPH_LEN / 4) << 4;
+	/* Send the packet. */
+	goto tcp_send_seqoff;
+      }
+#else /* UIP_TCP_WINDOW_SEGMENTS > 1 */
       if(uip_slen > 0 && uip_connr->len > 0) {
 	/* Add the length of the IP and TCP headers. */
 	uip_len = uip_connr->len + UIP_TCPIP_HLEN;
@@ -1709,9 +3857,15 @@ uip_process(u8_t flag)
 	/* Send the packet. */
 	goto tcp_send_noopts;
       }
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
       /* If there is no data to send, just send out a pure ACK if
 	 there is newdata. */
       if(uip_flags & UIP_NEWDATA) {
+#if UIP_TCP_DELAYED_ACK
+	if(ack_delay(uip_connr, flag)) {
+	  goto drop;
+	}
+#endif /* UIP_TCP_DELAYED_ACK */
 	uip_len = UIP_TCPIP_HLEN;
 	BUF->flags = TCP_ACK;
 	goto tcp_send_noopts;
@@ -1722,7 +3876,7 @@ uip_process(u8_t flag)
     /* We can close this connection if the peer has acknowledged our
        FIN. This is indicated by the UIP_ACKDATA flag. */
     if(uip_flags & UIP_ACKDATA) {
-      uip_connr->tcpstateflags = UIP_CLOSED;
+      SET_CLOSED(uip_connr);
       uip_flags = UIP_CLOSE;
       UIP_APPCALL();
     }
@@ -1794,20 +3948,48 @@ uip_process(u8_t flag)
   uip_len = UIP_IPTCPH_LEN;
  tcp_send_noopts:
   BUF->tcpoffset = (UIP_TCPH_LEN / 4) << 4;
+#if UIP_TCP_SACK
+  /* Segments without data tell the remote host about the data held
+     in the out-of-order queue. */
+  if(uip_connr->sackok && uip_connr->ooq != NULL &&
+     uip_len == UIP_IPTCPH_LEN && (BUF->flags & TCP_RST) == 0) {
+    sack_output(uip_connr);
+  }
+#endif /* UIP_TCP_SACK */
  tcp_send:
   /* We're done with the input processing. We are now ready to send a
      reply. Our job is to fill in all the fields of the TCP and IP
      headers before calculating the checksum and finally send the
      packet. */
-  BUF->ackno[0] = uip_connr->rcv_nxt[0];
-  BUF->ackno[1] = uip_connr->rcv_nxt[1];
-  BUF->ackno[2] = uip_connr->rcv_nxt[2];
-  BUF->ackno[3] = uip_connr->rcv_nxt[3];
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+  /* Segments that carry no data are sent with the sequence number
+     that follows the data in flight. */
+  sndoff = uip_connr->nseg > 0? uip_connr->len: 0;
+ tcp_send_seqoff:
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+#if UIP_TCP_DELAYED_ACK
+  if(uip_connr->delack != 0) {
+    /* The segment acknowledges the data whose acknowledgment was
+       delayed. */
+    uip_connr->delack = 0;
+    UIP_STAT(++uip_stat.tcp.acksaved);
+  }
+#endif /* UIP_TCP_DELAYED_ACK */
+  SEQ_STORE(BUF->ackno, uip_connr->rcv_nxt);
   
-  BUF->seqno[0] = uip_connr->snd_nxt[0];
-  BUF->seqno[1] = uip_connr->snd_nxt[1];
-  BUF->seqno[2] = uip_connr->snd_nxt[2];
-  BUF->seqno[3] = uip_connr->snd_nxt[3];
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+#if UIP_TCP_SEQ32
+  SEQ_PUT(BUF->seqno, uip_connr->snd_nxt + sndoff);
+#else /* UIP_TCP_SEQ32 */
+  uip_add32(uip_connr->snd_nxt, sndoff);
+  BUF->seqno[0] = uip_acc32[0];
+  BUF->seqno[1] = uip_acc32[1];
+  BUF->seqno[2] = uip_acc32[2];
+  BUF->seqno[3] = uip_acc32[3];
+#endif /* UIP_TCP_SEQ32 */
+#else /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+  SEQ_STORE(BUF->seqno, uip_connr->snd_nxt);
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
 
   BUF->proto = UIP_PROTO_TCP;
   
@@ -1822,9 +4004,24 @@ uip_process(u8_t flag)
        window so that the remote host will stop sending data. */
     BUF->wnd[0] = BUF->wnd[1] = 0;
   } else {
+#if UIP_TCP_WINDOW_SCALE || UIP_PACKETS
+    rcv_window(uip_connr);
+#else /* UIP_TCP_WINDOW_SCALE || UIP_PACKETS */
     BUF->wnd[0] = ((UIP_RECEIVE_WINDOW) >> 8);
     BUF->wnd[1] = ((UIP_RECEIVE_WINDOW) & 0xff);
+#endif /* UIP_TCP_WINDOW_SCALE || UIP_PACKETS */
+  }
+
+#if UIP_ZEROCOPY
+  /* The data of a segment sent with uip_sendref() follows the
+     headers, which are all that is in uip_buf. */
+  if(sendref != NULL) {
+    uip_reflen = uip_len - UIP_IPH_LEN - ((BUF->tcpoffset >> 4) << 2);
+    if(uip_reflen > 0) {
+      uip_appdata = (void *)sendref;
+    }
   }
+#endif /* UIP_ZEROCOPY */
 
  tcp_send_noconn:
   BUF->ttl = UIP_TTL;
@@ -1869,10 +4066,30 @@ uip_process(u8_t flag)
 	       (BUF->len[0] << 8) | BUF->len[1]);
   
   UIP_STAT(++uip_stat.ip.sent);
+#if UIP_TCP_TIME_WAIT_CONNS
+  if(uip_connr != NULL && uip_connr->tcpstateflags == UIP_TIME_WAIT) {
+    tw_enter(uip_connr);
+  }
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
+#if UIP_TCP_TIMER_WHEEL
+  if(uip_connr != NULL) {
+    wheel_update(uip_connr);
+  }
+#endif /* UIP_TCP_TIMER_WHEEL */
   /* Return and let the caller do the actual transmission. */
   uip_flags = 0;
   return;
  drop:
+#if UIP_TCP_TIME_WAIT_CONNS
+  if(uip_connr != NULL && uip_connr->tcpstateflags == UIP_TIME_WAIT) {
+    tw_enter(uip_connr);
+  }
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
+#if UIP_TCP_TIMER_WHEEL
+  if(uip_connr != NULL) {
+    wheel_update(uip_connr);
+  }
+#endif /* UIP_TCP_TIMER_WHEEL */
   uip_len = 0;
   uip_flags = 0;
   return;
@@ -1892,6 +4109,33 @@ uip_send(const void *data, int len)
     if(data != uip_sappdata) {
       memcpy(uip_sappdata, (data), uip_slen);
     }
+#if UIP_ZEROCOPY
+    sendref = NULL;
+    uip_refsumlen = 0;
+#endif /* UIP_ZEROCOPY */
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_ZEROCOPY
+void
+uip_sendref(const void *data, int len)
+{
+  if(len > 0) {
+    uip_slen = len;
+    sendref = data;
+    uip_refsumlen = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_sendrefsum(const void *data, int len, u16_t sum)
+{
+  if(len > 0) {
+    uip_slen = len;
+    sendref = data;
+    uip_refsum = sum;
+    uip_refsumlen = len;
   }
 }
+#endif /* UIP_ZEROCOPY */
 /** @} */
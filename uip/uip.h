@@ -55,6 +55,10 @@
 
 #include "uipopt.h"
 
+#if UIP_TCP_CLOCK_RTO
+#include "timer.h"
+#endif /* UIP_TCP_CLOCK_RTO */
+
 /**
  * Repressentation of an IP address.
  *
@@ -187,6 +191,46 @@ typedef uip_ip4addr_t uip_ipaddr_t;
  */
 void uip_init(void);
 
+#if UIP_DYNAMIC_TABLES
+/**
+ * The sizes of the connection tables.
+ *
+ * \sa uip_settables()
+ */
+struct uip_tables {
+  u16_t conns;        /**< The maximum number of TCP connections. */
+  u16_t listenports;  /**< The maximum number of listening TCP
+			 ports. */
+  u8_t udp_conns;     /**< The maximum number of UDP connections. */
+};
+
+/**
+ * Allocate the connection tables.
+ *
+ * This function must be called before uip_init() when uIP is
+ * configured with UIP_DYNAMIC_TABLES. Tables that were allocated by
+ * an earlier call are freed.
+ *
+ * \param tables A pointer to the sizes of the tables. At least one
+ * TCP connection and one listening port are needed.
+ *
+ * \return Non-zero if the tables could be allocated. If zero is
+ * returned, uIP cannot be used.
+ */
+int uip_settables(const struct uip_tables *tables);
+
+/* The number of entries in use at the beginning of each table. */
+extern u16_t uip_conns_used, uip_listenports_used;
+extern u8_t uip_udp_conns_used;
+
+#undef UIP_CONNS
+#define UIP_CONNS uip_conns_used
+#undef UIP_LISTENPORTS
+#define UIP_LISTENPORTS uip_listenports_used
+#undef UIP_UDP_CONNS
+#define UIP_UDP_CONNS uip_udp_conns_used
+#endif /* UIP_DYNAMIC_TABLES */
+
 /**
  * uIP initialization function.
  *
@@ -194,6 +238,16 @@ void uip_init(void);
  */
 void uip_setipid(u16_t id);
 
+#if UIP_TCP_SYNCOOKIES
+/**
+ * Set the secret that SYN cookies are keyed with.
+ *
+ * This function should be called at boot time with a random value,
+ * so that SYN cookies cannot be forged (see UIP_TCP_SYNCOOKIES).
+ */
+void uip_setcookiesecret(unsigned long secret);
+#endif /* UIP_TCP_SYNCOOKIES */
+
 /** @} */
 
 /**
@@ -323,6 +377,102 @@ void uip_setipid(u16_t id);
 #define uip_periodic_conn(conn) do { uip_conn = conn; \
                                      uip_process(UIP_TIMER); } while (0)
 
+#if UIP_TCP_TIMER_WHEEL
+/**
+ * Advance the TCP timer wheel by one tick.
+ *
+ * When UIP_TCP_TIMER_WHEEL is set, this function replaces the loop
+ * over all connections with uip_periodic(). It should be called when
+ * the periodic uIP timer goes off, followed by uip_periodic_conn() for
+ * every connection returned by uip_periodic_due():
+ \code
+  uip_periodic_tick();
+  while((conn = uip_periodic_due()) != NULL) {
+    uip_periodic_conn(conn);
+    if(uip_len > 0) {
+      devicedriver_send();
+    }
+  }
+ \endcode
+ *
+ * The due connections should be processed before any incoming
+ * packets, or their timers may fire one tick late.
+ */
+void uip_periodic_tick(void);
+
+/**
+ * Get the next connection that is due for periodic processing.
+ *
+ * \return A pointer to the connection, or NULL if there are no more
+ * due connections for this tick.
+ */
+struct uip_conn *uip_periodic_due(void);
+#endif /* UIP_TCP_TIMER_WHEEL */
+
+#if UIP_TCP_CLOCK_RTO
+/**
+ * Check if any TCP retransmission timer may have expired.
+ *
+ * When UIP_TCP_CLOCK_RTO is set, the retransmission timers run
+ * independently of the periodic timer. The device driver should call
+ * this function often, and if it returns non-zero, call
+ * uip_periodic_rexmit() for every connection:
+ \code
+  if(uip_rexmit_expired()) {
+    for(i = 0; i < UIP_CONNS; ++i) {
+      uip_periodic_rexmit(i);
+      if(uip_len > 0) {
+        devicedriver_send();
+      }
+    }
+  }
+ \endcode
+ *
+ * Delayed acknowledgments (see UIP_TCP_DELAYED_ACK) are sent in the
+ * same way.
+ *
+ * \return Non-zero if the earliest retransmission timer has expired.
+ */
+u8_t uip_rexmit_expired(void);
+
+/**
+ * Get the time until the earliest retransmission timer expires.
+ *
+ * \param max The value to return if no retransmission timer is
+ * running, or if it expires later.
+ *
+ * \return The number of clock ticks until the earliest
+ * retransmission timer expires, but no more than max.
+ */
+clock_time_t uip_rexmit_remaining(clock_time_t max);
+
+/**
+ * Check the retransmission timer of a connection identified by its
+ * number.
+ *
+ * If the timer has expired, the oldest outstanding segment is
+ * retransmitted and uip_len is set to a value larger than zero. No
+ * other periodic processing is done.
+ *
+ * \param conn The number of the connection.
+ *
+ * \hideinitializer
+ */
+#define uip_periodic_rexmit(conn) do { uip_conn = &uip_conns[conn]; \
+                                       uip_process(UIP_REXMIT_TIMER); } while (0)
+
+/**
+ * Check the retransmission timer of a connection identified by a
+ * pointer to its structure.
+ *
+ * \param conn A pointer to the uip_conn struct for the connection.
+ *
+ * \hideinitializer
+ */
+#define uip_periodic_rexmit_conn(conn) do { uip_conn = conn; \
+                                            uip_process(UIP_REXMIT_TIMER); } while (0)
+#endif /* UIP_TCP_CLOCK_RTO */
+
 /**
  * Reuqest that a particular connection should be polled.
  *
@@ -337,6 +487,55 @@ void uip_setipid(u16_t id);
 #define uip_poll_conn(conn) do { uip_conn = conn; \
                                  uip_process(UIP_POLL_REQUEST); } while (0)
 
+#if UIP_TCP_REORDER
+struct uip_conn;
+
+/**
+ * Check if a connection has a queued out-of-order segment that can be
+ * delivered.
+ *
+ * When UIP_TCP_REORDER is set, segments that arrive ahead of a
+ * missing segment are queued. After the missing segment has been
+ * processed, the device driver should deliver the queued segments
+ * that now follow it in sequence:
+ \code
+  uip_input();
+  if(uip_len > 0) {
+    devicedriver_send();
+    while(uip_conn != NULL && uip_reorder_ready(uip_conn)) {
+      uip_reorder_conn(uip_conn);
+      if(uip_len > 0) {
+        devicedriver_send();
+      }
+    }
+  }
+ \endcode
+ *
+ * Queued segments that have become old are freed by this function.
+ *
+ * \param conn A pointer to the uip_conn struct for the connection.
+ *
+ * \return Non-zero if the first queued segment starts at the next
+ * expected sequence number.
+ */
+u8_t uip_reorder_ready(struct uip_conn *conn);
+
+/**
+ * Deliver the next queued out-of-order segment of a connection.
+ *
+ * The segment is processed as if it had just been received, except
+ * that its acknowledgment number is ignored. The
+ * application is called with the data, and uip_len is set to a value
+ * larger than zero if an acknowledgment should be sent.
+ *
+ * \param conn A pointer to the uip_conn struct for the connection.
+ *
+ * \hideinitializer
+ */
+#define uip_reorder_conn(conn) do { uip_conn = conn; \
+                                    uip_process(UIP_REORDER); } while (0)
+#endif /* UIP_TCP_REORDER */
+
 
 #if UIP_UDP
 /**
@@ -418,8 +617,15 @@ void uip_setipid(u16_t id);
     }
  }
  \endcode
+ *
+ * \note If the packet buffer pool is used (UIP_PACKETS > 0), uip_buf
+ * is a pointer to the buffer of the current packet.
  */
+#if UIP_PACKETS
+extern u8_t *uip_buf;
+#else /* UIP_PACKETS */
 extern u8_t uip_buf[UIP_BUFSIZE+2];
+#endif /* UIP_PACKETS */
 
 /** @} */
 
@@ -537,6 +743,41 @@ struct uip_conn *uip_connect(uip_ipaddr_t *ripaddr, u16_t port);
  */
 void uip_send(const void *data, int len);
 
+#if UIP_ZEROCOPY
+/**
+ * Send data on the current connection without copying it.
+ *
+ * This function works like uip_send(), but the data is sent from
+ * where it is instead of being copied into uip_buf. The data must
+ * stay unchanged until it has been acknowledged, since it may have to
+ * be retransmitted, and the application must pass the same data again
+ * when it is asked to retransmit. This suits constant data such as
+ * the files of the web server.
+ *
+ * \param data A pointer to the data which is to be sent.
+ *
+ * \param len The maximum amount of data bytes to be sent.
+ */
+void uip_sendref(const void *data, int len);
+
+/**
+ * Send data on the current connection without copying or summing it.
+ *
+ * This function works like uip_sendref(), but the application also
+ * passes the 16-bit one's complement sum of the data, in host byte
+ * order, as computed by uip_chksum() and converted with ntohs(). The
+ * TCP checksum is then computed from the sum and the headers
+ * only. The sum is ignored if less data than len is sent.
+ *
+ * \param data A pointer to the data which is to be sent.
+ *
+ * \param len The maximum amount of data bytes to be sent.
+ *
+ * \param sum The one's complement sum of the len bytes of data.
+ */
+void uip_sendrefsum(const void *data, int len, u16_t sum);
+#endif /* UIP_ZEROCOPY */
+
 /**
  * The length of any incoming data that is currently avaliable (if avaliable)
  * in the uip_appdata buffer.
@@ -701,6 +942,61 @@ void uip_send(const void *data, int len);
  */
 #define uip_rexmit()     (uip_flags & UIP_REXMIT)
 
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+/**
+ * The number of bytes that were acknowledged.
+ *
+ * When more than one segment may be in flight (UIP_TCP_WINDOW_SEGMENTS
+ * > 1), an acknowledgment may cover one or more of the segments that
+ * were previously sent. If uip_acked() is non-zero, this reduces to
+ * the number of bytes that the application no longer needs to keep
+ * for retransmission.
+ *
+ * \hideinitializer
+ */
+#define uip_ackedlen()     uip_acklen
+
+/**
+ * The offset of the data that should be retransmitted.
+ *
+ * When more than one segment may be in flight (UIP_TCP_WINDOW_SEGMENTS
+ * > 1) and uip_rexmit() is non-zero, the application should resend
+ * uip_rexmitlen() bytes starting this many bytes after the oldest
+ * unacknowledged byte.
+ *
+ * \hideinitializer
+ */
+#define uip_rexmitoffset() uip_rexmit_off
+
+/**
+ * The number of bytes that should be retransmitted.
+ *
+ * \sa uip_rexmitoffset()
+ *
+ * \hideinitializer
+ */
+#define uip_rexmitlen()    uip_rexmit_len
+
+/**
+ * The number of bytes that a connection can send right now.
+ *
+ * When more than one segment may be in flight (UIP_TCP_WINDOW_SEGMENTS
+ * > 1), the application may send new data even if some of its data
+ * has not yet been acknowledged. This function returns how much new
+ * data the connection accepts in the next segment, taking the MSS,
+ * the window advertised by the remote host and the number of
+ * segments already in flight into account. Data passed to uip_send()
+ * beyond this amount is discarded.
+ *
+ * This function can also be used by the device driver to find out if
+ * it is worth polling a connection with uip_poll_conn() after a
+ * packet has been sent.
+ *
+ * \param conn A pointer to the uip_conn structure for the connection.
+ */
+u16_t uip_sendroom(struct uip_conn *conn);
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+
 /**
  * Is the connection being polled by uIP?
  *
@@ -772,7 +1068,11 @@ struct uip_udp_conn *uip_udp_new(uip_ipaddr_t *ripaddr, u16_t rport);
  *
  * \hideinitializer
  */
+#if UIP_EPHEMERAL_PORTS
+#define uip_udp_remove(conn) uip_udp_setport(conn, 0)
+#else /* UIP_EPHEMERAL_PORTS */
 #define uip_udp_remove(conn) (conn)->lport = 0
+#endif /* UIP_EPHEMERAL_PORTS */
 
 /**
  * Bind a UDP connection to a local port.
@@ -784,7 +1084,30 @@ struct uip_udp_conn *uip_udp_new(uip_ipaddr_t *ripaddr, u16_t rport);
  *
  * \hideinitializer
  */
+#if UIP_EPHEMERAL_PORTS
+#define uip_udp_bind(conn, port) uip_udp_setport(conn, port)
+#else /* UIP_EPHEMERAL_PORTS */
 #define uip_udp_bind(conn, port) (conn)->lport = port
+#endif /* UIP_EPHEMERAL_PORTS */
+
+#if UIP_EPHEMERAL_PORTS
+/**
+ * Change the local port of a UDP connection.
+ *
+ * This function is used by uip_udp_bind() and uip_udp_remove(). It
+ * gives the port that was allocated by uip_udp_new() back to the
+ * ephemeral port allocator, and reserves a new port that lies in the
+ * ephemeral range so that uip_udp_new() and uip_connect() do not
+ * hand it out as well.
+ *
+ * \param conn A pointer to the uip_udp_conn structure for the
+ * connection.
+ *
+ * \param port The new local port number, in network byte order, or
+ * 0 to remove the connection.
+ */
+void uip_udp_setport(struct uip_udp_conn *conn, u16_t port);
+#endif /* UIP_EPHEMERAL_PORTS */
 
 /**
  * Send a UDP datagram of length len on the current connection.
@@ -1098,6 +1421,40 @@ u16_t htons(u16_t val);
  */
 extern void *uip_appdata;
 
+#if UIP_ZEROCOPY
+/**
+ * The number of bytes at the end of the outgoing packet that are
+ * not in uip_buf.
+ *
+ * If data has been sent with uip_sendref(), this variable holds the
+ * length of the data, which is at uip_appdata, and the first uip_len
+ * - uip_reflen bytes of the packet are in uip_buf. It is set for each
+ * packet that uIP produces, and is zero unless the packet carries
+ * such data.
+ \code
+ void
+ devicedriver_send(void)
+ {
+    hwsend(&uip_buf[0], uip_len - uip_reflen);
+    if(uip_reflen > 0) {
+      hwsend(uip_appdata, uip_reflen);
+    }
+ }
+ \endcode
+ */
+extern u16_t uip_reflen;
+
+/**
+ * The sum of the data sent with uip_sendrefsum(), and the number of
+ * bytes it covers.
+ *
+ * The checksum functions use uip_refsum instead of summing the data
+ * at uip_appdata if uip_refsumlen equals uip_reflen, which is not the
+ * case if uIP has sent less data than the application asked for.
+ */
+extern u16_t uip_refsum, uip_refsumlen;
+#endif /* UIP_ZEROCOPY */
+
 #if UIP_URGDATA > 0
 /* u8_t *uip_urgdata:
  *
@@ -1139,6 +1496,10 @@ extern u16_t uip_len;
 extern u16_t uip_urglen, uip_surglen;
 #endif /* UIP_URGDATA > 0 */
 
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+extern u16_t uip_acklen, uip_rexmit_off, uip_rexmit_len;
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+
 
 /**
  * Representation of a uIP TCP connection.
@@ -1157,10 +1518,17 @@ struct uip_conn {
   u16_t rport;        /**< The local remote TCP port, in network byte
 			 order. */
   
+#if UIP_TCP_SEQ32
+  u32_t rcv_nxt;      /**< The sequence number that we expect to
+			 receive next. */
+  u32_t snd_nxt;      /**< The sequence number that was last sent by
+			 us. */
+#else /* UIP_TCP_SEQ32 */
   u8_t rcv_nxt[4];    /**< The sequence number that we expect to
 			 receive next. */
   u8_t snd_nxt[4];    /**< The sequence number that was last sent by
                          us. */
+#endif /* UIP_TCP_SEQ32 */
   u16_t len;          /**< Length of the data that was previously sent. */
   u16_t mss;          /**< Current maximum segment size for the
 			 connection. */
@@ -1175,6 +1543,96 @@ struct uip_conn {
   u8_t timer;         /**< The retransmission timer. */
   u8_t nrtx;          /**< The number of retransmissions for the last
 			 segment sent. */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+  u16_t snd_wnd;      /**< The window advertised by the remote host. */
+  u8_t nseg;          /**< The number of unacknowledged data
+			 segments. */
+  u16_t seglen[UIP_TCP_WINDOW_SEGMENTS]; /**< The lengths of the
+					    unacknowledged data
+					    segments, oldest first. */
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
+#if UIP_TCP_CC
+  const struct uip_cc *cc; /**< The congestion avoidance algorithm. */
+  u16_t cwnd;         /**< The congestion window, in bytes. */
+  u16_t ssthresh;     /**< The slow start threshold, in bytes. */
+  u16_t recover;      /**< The number of bytes that must be
+			 acknowledged before loss recovery ends. */
+  u8_t dupacks;       /**< The number of duplicate acknowledgments
+			 in a row. */
+  u8_t recovery;      /**< Non-zero during loss recovery. */
+  u16_t ccstate[5];   /**< Private state of the congestion avoidance
+			 algorithm. */
+#endif /* UIP_TCP_CC */
+
+#if UIP_TCP_HASH
+  struct uip_conn *hnext; /**< The next connection in the same hash
+			     bucket. */
+#endif /* UIP_TCP_HASH */
+#if UIP_TCP_TIMER_WHEEL
+  struct uip_conn *wnext; /**< The next connection in the same timer
+			     wheel slot. */
+  struct uip_conn *wprev; /**< The previous connection in the same
+			     timer wheel slot. */
+  u16_t tick;         /**< The tick up to which the timer is counted. */
+  u16_t due;          /**< The tick at which the connection is due. */
+  u8_t wslot;         /**< The timer wheel slot of the connection. */
+#endif /* UIP_TCP_TIMER_WHEEL */
+#if UIP_TCP_CLOCK_RTO
+  struct timer rt;    /**< The retransmission timer. */
+  clock_time_t rtt_start; /**< The time when the timed segment was
+			     sent. */
+  clock_time_t srtt;  /**< The smoothed round-trip time, times 8. */
+  clock_time_t rttvar; /**< The round-trip time variation, times 4. */
+  clock_time_t rtoclk; /**< The retransmission timeout, in clock
+			  ticks. */
+  u16_t rtt_seq;      /**< The number of outstanding bytes up to the
+			 end of the timed segment, or 0 if no segment
+			 is timed. */
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_TCP_DELAYED_ACK
+  struct timer at;    /**< The delayed acknowledgment timer. */
+  u8_t delack;        /**< Non-zero if received data has not been
+			 acknowledged yet. */
+#endif /* UIP_TCP_DELAYED_ACK */
+#if UIP_TCP_WINDOW_SCALE
+  u8_t snd_wscale;    /**< The window scale shift count of the remote
+			 host. */
+  u8_t rcv_wscale;    /**< The window scale shift count of our
+			 advertised window, or 0 if window scaling is
+			 not used on the connection. */
+#endif /* UIP_TCP_WINDOW_SCALE */
+#if UIP_TCP_REORDER
+  struct uip_packet *ooq; /**< The queue of segments received out of
+			     order, sorted by sequence number. */
+  u8_t ooqlen;        /**< The number of segments in the queue. */
+#endif /* UIP_TCP_REORDER */
+#if UIP_TCP_SENDBUFS
+  struct uip_sendbuf *sendbuf; /**< The send buffer of the connection,
+				  or NULL if it has none. */
+#endif /* UIP_TCP_SENDBUFS */
+#if UIP_TCP_SACK
+  u8_t sackok;        /**< Non-zero if selective acknowledgments are
+			 used on the connection. */
+#if UIP_TCP_SEQ32
+  u32_t ooqnew;       /**< The sequence number of the most recently
+			 queued out-of-order segment. */
+#else /* UIP_TCP_SEQ32 */
+  u8_t ooqnew[4];     /**< The sequence number of the most recently
+			 queued out-of-order segment. */
+#endif /* UIP_TCP_SEQ32 */
+#if UIP_TCP_CC
+  u16_t sacked;       /**< Bitmap of the unacknowledged segments that
+			 the remote host has selectively acknowledged,
+			 oldest segment in bit 0. */
+  u16_t rtxed;        /**< Bitmap of the unacknowledged segments that
+			 have been retransmitted during loss
+			 recovery. */
+#endif /* UIP_TCP_CC */
+#endif /* UIP_TCP_SACK */
+#if UIP_EPHEMERAL_PORTS
+  u8_t ephemeral;     /**< Non-zero if the local port was allocated by
+			 uip_connect(). */
+#endif /* UIP_EPHEMERAL_PORTS */
 
   /** The application state. */
   uip_tcp_appstate_t appstate;
@@ -1189,7 +1647,11 @@ struct uip_conn {
  */
 extern struct uip_conn *uip_conn;
 /* The array containing all uIP connections. */
+#if UIP_DYNAMIC_TABLES
+extern struct uip_conn *uip_conns;
+#else /* UIP_DYNAMIC_TABLES */
 extern struct uip_conn uip_conns[UIP_CONNS];
+#endif /* UIP_DYNAMIC_TABLES */
 /**
  * \addtogroup uiparch
  * @{
@@ -1212,6 +1674,10 @@ struct uip_udp_conn {
   u16_t lport;        /**< The local port number in network byte order. */
   u16_t rport;        /**< The remote port number in network byte order. */
   u8_t  ttl;          /**< Default time-to-live. */
+#if UIP_EPHEMERAL_PORTS
+  u8_t ephemeral;     /**< Non-zero if the local port is held in the
+			 ephemeral port allocator. */
+#endif /* UIP_EPHEMERAL_PORTS */
 
   /** The application state. */
   uip_udp_appstate_t appstate;
@@ -1221,7 +1687,11 @@ struct uip_udp_conn {
  * The current UDP connection.
  */
 extern struct uip_udp_conn *uip_udp_conn;
+#if UIP_DYNAMIC_TABLES
+extern struct uip_udp_conn *uip_udp_conns;
+#else /* UIP_DYNAMIC_TABLES */
 extern struct uip_udp_conn uip_udp_conns[UIP_UDP_CONNS];
+#endif /* UIP_DYNAMIC_TABLES */
 #endif /* UIP_UDP */
 
 /**
@@ -1271,6 +1741,39 @@ struct uip_stats {
 			     connections was avaliable. */
     uip_stats_t synrst;   /**< Number of SYNs for closed ports,
 			     triggering a RST. */
+#if UIP_TCP_SYNCOOKIES
+    uip_stats_t cookiesent; /**< Number of SYNs that were answered
+			       with a SYN cookie. */
+    uip_stats_t cookierecv; /**< Number of connections that were
+			       created from a SYN cookie. */
+    uip_stats_t cookiebad; /**< Number of acknowledgments for a
+			      listening port that carried no valid
+			      SYN cookie. */
+#endif /* UIP_TCP_SYNCOOKIES */
+#if UIP_TCP_TIME_WAIT_CONNS
+    uip_stats_t reclaimed; /**< Number of connections that were moved
+			      to the TIME_WAIT table. */
+#endif /* UIP_TCP_TIME_WAIT_CONNS */
+#if UIP_TCP_REORDER
+    uip_stats_t ooqueued; /**< Number of out-of-order segments that
+			     were queued. */
+    uip_stats_t oomerged; /**< Number of queued segments that were
+			     delivered in order. */
+    uip_stats_t oodrop;   /**< Number of out-of-order segments that
+			     were dropped or freed without being
+			     delivered. */
+#endif /* UIP_TCP_REORDER */
+#if UIP_TCP_DELAYED_ACK
+    uip_stats_t ackdelayed; /**< Number of acknowledgments that were
+			       delayed. */
+    uip_stats_t acksaved; /**< Number of delayed acknowledgments that
+			     were sent along with data or with a later
+			     acknowledgment. */
+#endif /* UIP_TCP_DELAYED_ACK */
+#if UIP_TCP_FASTPATH
+    uip_stats_t predicted; /**< Number of TCP segments that were
+			      handled by header prediction. */
+#endif /* UIP_TCP_FASTPATH */
   } tcp;                  /**< TCP statistics. */
 #if UIP_UDP
   struct {
@@ -1367,6 +1870,15 @@ void uip_process(u8_t flag);
 #if UIP_UDP
 #define UIP_UDP_TIMER     5
 #endif /* UIP_UDP */
+#if UIP_TCP_CLOCK_RTO
+#define UIP_REXMIT_TIMER  6     /* Tells uIP that the retransmission
+				   timer of a connection should be
+				   checked. */
+#endif /* UIP_TCP_CLOCK_RTO */
+#if UIP_TCP_REORDER
+#define UIP_REORDER       7     /* Tells uIP that a queued out-of-order
+				   segment should be delivered. */
+#endif /* UIP_TCP_REORDER */
 
 /* The TCP states used in the uip_conn->tcpstateflags. */
 #define UIP_CLOSED      0
@@ -1381,6 +1893,9 @@ void uip_process(u8_t flag);
 #define UIP_TS_MASK     15
   
 #define UIP_STOPPED      16
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+#define UIP_CLOSE_PENDING 32
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
 
 /* The TCP and IP headers. */
 struct uip_tcpip_hdr {
@@ -1594,6 +2109,48 @@ u16_t uip_tcpchksum(void);
  */
 u16_t uip_udpchksum(void);
 
+/**
+ * Update a checksum for a changed 16-bit field.
+ *
+ * This function computes a new Internet checksum from the old one
+ * when a 16-bit word covered by the checksum is changed, without
+ * summing the rest of the packet again (RFC1624). The old and new
+ * values may also be the one's complement sums of a removed or added
+ * block of data that starts at an even offset from the start of the
+ * checksummed data, such as a truncated payload. The sum of a block
+ * is given by htons(uip_chksum()).
+ *
+ * \param chksum The old checksum, as it is stored in the header
+ * (network byte order).
+ *
+ * \param oldval The old value of the field, in host byte order.
+ *
+ * \param newval The new value of the field, in host byte order.
+ *
+ * \return The new checksum, in network byte order.
+ */
+u16_t uip_chksum_update16(u16_t chksum, u16_t oldval, u16_t newval);
+
+/**
+ * Update a checksum for a changed 32-bit field.
+ *
+ * This function works like uip_chksum_update16(), but for a 32-bit
+ * field that starts at an even offset, such as a TCP sequence number.
+ *
+ * \param chksum The old checksum, as it is stored in the header
+ * (network byte order).
+ *
+ * \param oldval A pointer to the old value of the field, in network
+ * byte order.
+ *
+ * \param newval A pointer to the new value of the field, in network
+ * byte order.
+ *
+ * \return The new checksum, in network byte order.
+ */
+u16_t uip_chksum_update32(u16_t chksum, const u8_t *oldval,
+			  const u8_t *newval);
+
 
 #endif /* __UIP_H__ */
 
@@ -309,6 +309,9 @@ uip_arp_arpin(void)
 
       BUF->ethhdr.type = HTONS(UIP_ETHTYPE_ARP);
       uip_len = sizeof(struct arp_hdr);
+#if UIP_ZEROCOPY
+      uip_reflen = 0;
+#endif /* UIP_ZEROCOPY */
     }
     break;
   case HTONS(ARP_REPLY):
@@ -405,6 +408,10 @@ uip_arp_out(void)
       uip_appdata = &uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN];
     
       uip_len = sizeof(struct arp_hdr);
+#if UIP_ZEROCOPY
+      /* The packet that was to be sent is replaced by the request. */
+      uip_reflen = 0;
+#endif /* UIP_ZEROCOPY */
       return;
     }
 
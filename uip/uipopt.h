@@ -261,6 +261,117 @@
 #define UIP_LISTENPORTS UIP_CONF_MAX_LISTENPORTS
 #endif /* UIP_CONF_MAX_LISTENPORTS */
 
+/**
+ * Determines if incoming TCP segments should be demultiplexed using
+ * hash tables.
+ *
+ * By default, uIP finds the connection for an incoming segment by
+ * searching through the entire connection table, and the listening
+ * ports by searching through the entire list of listening ports. This
+ * is the smallest solution, but the cost of each incoming segment
+ * grows with the size of the tables. If this option is set, uIP keeps
+ * a hash table indexed by the local port, remote port and remote IP
+ * address of every active connection, and a hash table of the
+ * listening ports, so that the lookup cost is independent of
+ * UIP_CONNS and UIP_LISTENPORTS.
+ *
+ * Each TCP connection requires an additional pointer of memory.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_HASH
+#define UIP_TCP_HASH UIP_CONF_TCP_HASH
+#else /* UIP_CONF_TCP_HASH */
+#define UIP_TCP_HASH    0
+#endif /* UIP_CONF_TCP_HASH */
+
+/**
+ * The number of buckets in the TCP connection hash table.
+ *
+ * Must be a power of two. Only used if UIP_TCP_HASH is set. The
+ * lookup cost stays flat only while there are not many more
+ * connections than buckets.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_HASH_SIZE
+#define UIP_TCP_HASH_SIZE UIP_CONF_TCP_HASH_SIZE
+#else /* UIP_CONF_TCP_HASH_SIZE */
+#define UIP_TCP_HASH_SIZE 64
+#endif /* UIP_CONF_TCP_HASH_SIZE */
+
+/**
+ * The number of buckets in the listening port hash table.
+ *
+ * Must be a power of two. Only used if UIP_TCP_HASH is set.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_LISTEN_HASH_SIZE
+#define UIP_LISTEN_HASH_SIZE UIP_CONF_LISTEN_HASH_SIZE
+#else /* UIP_CONF_LISTEN_HASH_SIZE */
+#define UIP_LISTEN_HASH_SIZE 16
+#endif /* UIP_CONF_LISTEN_HASH_SIZE */
+
+/**
+ * Determines if header prediction should be used for TCP.
+ *
+ * With header prediction, the connection that received the previous
+ * TCP segment is tried first when an incoming segment is
+ * demultiplexed. On an established connection, an in-order data
+ * segment that acknowledges nothing new, and a pure acknowledgment
+ * of outstanding data, skip most of the general TCP input
+ * processing.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_FASTPATH
+#define UIP_TCP_FASTPATH UIP_CONF_TCP_FASTPATH
+#else /* UIP_CONF_TCP_FASTPATH */
+#define UIP_TCP_FASTPATH 0
+#endif /* UIP_CONF_TCP_FASTPATH */
+
+/**
+ * Determines if TCP sequence numbers should be kept as native 32-bit
+ * integers.
+ *
+ * By default, the sequence numbers of a connection are kept as
+ * arrays of four bytes in network byte order and are updated with
+ * uip_add32(), which suits 8-bit CPUs. On 32-bit and 64-bit CPUs,
+ * this option keeps them as u32_t integers in host byte order
+ * instead, which makes the sequence number arithmetic much
+ * cheaper. The u32_t type must be defined in uip-conf.h.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SEQ32
+#define UIP_TCP_SEQ32 UIP_CONF_TCP_SEQ32
+#else /* UIP_CONF_TCP_SEQ32 */
+#define UIP_TCP_SEQ32 0
+#endif /* UIP_CONF_TCP_SEQ32 */
+
+/**
+ * Determines if the TCP timers should be kept in a timer wheel.
+ *
+ * By default, the periodic timer calls uip_periodic() for every
+ * connection in the uip_conns table, including connections that are
+ * closed or have no timer running. If this option is set, uIP keeps
+ * each connection that has a retransmission, TIME_WAIT or poll
+ * deadline in a hierarchical timer wheel, and the device driver uses
+ * uip_periodic_tick() and uip_periodic_due() to visit only the
+ * connections whose deadline has been reached.
+ *
+ * Each TCP connection requires two additional pointers and five bytes
+ * of memory.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_TIMER_WHEEL
+#define UIP_TCP_TIMER_WHEEL UIP_CONF_TCP_TIMER_WHEEL
+#else /* UIP_CONF_TCP_TIMER_WHEEL */
+#define UIP_TCP_TIMER_WHEEL 0
+#endif /* UIP_CONF_TCP_TIMER_WHEEL */
+
 /**
  * Determines if support for TCP urgent data notification should be
  * compiled in.
@@ -296,6 +407,47 @@
  */
 #define UIP_MAXSYNRTX      5
 
+/**
+ * The maximum number of half-open connections per listening port.
+ *
+ * A connection is half-open from the time its SYN is received until
+ * the remote host acknowledges our SYNACK. When a listening port
+ * already has this many half-open connections, further SYNs for the
+ * port are dropped, or answered with a SYN cookie if
+ * UIP_TCP_SYNCOOKIES is set, so that a SYN flood cannot fill the
+ * whole connection table. Zero means no limit.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SYN_BACKLOG
+#define UIP_TCP_SYN_BACKLOG UIP_CONF_TCP_SYN_BACKLOG
+#else /* UIP_CONF_TCP_SYN_BACKLOG */
+#define UIP_TCP_SYN_BACKLOG 0
+#endif /* UIP_CONF_TCP_SYN_BACKLOG */
+
+/**
+ * Determines if SYN cookies should be used.
+ *
+ * With SYN cookies, a SYN that finds no free connection, or whose
+ * listening port has reached the UIP_TCP_SYN_BACKLOG limit, is
+ * answered with a SYNACK without keeping any state. The initial
+ * sequence number of the SYNACK encodes the connection and the MSS
+ * of the remote host, and the connection is created when the remote
+ * host acknowledges it. Window scaling and selective
+ * acknowledgments are not used on such connections.
+ *
+ * A cookie is valid for one to two minutes. The cookies are keyed
+ * with a secret that should be set with uip_setcookiesecret() at
+ * boot. This option requires UIP_TCP_CLOCK_RTO.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SYNCOOKIES
+#define UIP_TCP_SYNCOOKIES UIP_CONF_TCP_SYNCOOKIES
+#else /* UIP_CONF_TCP_SYNCOOKIES */
+#define UIP_TCP_SYNCOOKIES 0
+#endif /* UIP_CONF_TCP_SYNCOOKIES */
+
 /**
  * The TCP maximum segment size.
  *
@@ -319,6 +471,142 @@
 #define UIP_RECEIVE_WINDOW UIP_CONF_RECEIVE_WINDOW
 #endif
 
+/**
+ * The TCP window scale shift count (RFC7323).
+ *
+ * If this option is set to a value between 1 and 14, uIP offers the
+ * window scale option in its SYN and SYNACK segments, and if the
+ * remote host agrees, the advertised window is shifted right by this
+ * number of bits. This allows UIP_RECEIVE_WINDOW to be set to as much
+ * as 65535 << UIP_TCP_WINDOW_SCALE bytes. If the option is 0, no
+ * window scaling is done and the window is limited to 65535 bytes.
+ *
+ * When the packet pool is used (UIP_PACKETS), the advertised window
+ * is also limited to the number of full-sized segments that fit in
+ * the packet buffers.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_WINDOW_SCALE
+#define UIP_TCP_WINDOW_SCALE UIP_CONF_TCP_WINDOW_SCALE
+#else /* UIP_CONF_TCP_WINDOW_SCALE */
+#define UIP_TCP_WINDOW_SCALE 0
+#endif /* UIP_CONF_TCP_WINDOW_SCALE */
+
+/**
+ * The maximum number of unacknowledged segments a TCP connection may
+ * have in flight.
+ *
+ * With the default value of 1, uIP only keeps a single segment
+ * outstanding on each connection, which limits the throughput to one
+ * segment per round-trip time. Setting this option to a larger value
+ * lets the connection send several segments, within the window
+ * advertised by the peer, before the first one is acknowledged. The
+ * application then must keep track of all data that has not yet been
+ * acknowledged and must be prepared to regenerate any part of it when
+ * uip_rexmit() is set. See uip_sendroom(), uip_ackedlen(),
+ * uip_rexmitoffset() and uip_rexmitlen().
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_WINDOW_SEGMENTS
+#define UIP_TCP_WINDOW_SEGMENTS UIP_CONF_TCP_WINDOW_SEGMENTS
+#else /* UIP_CONF_TCP_WINDOW_SEGMENTS */
+#define UIP_TCP_WINDOW_SEGMENTS 1
+#endif /* UIP_CONF_TCP_WINDOW_SEGMENTS */
+
+/**
+ * Determines if TCP congestion control should be compiled in.
+ *
+ * Congestion control limits the number of bytes in flight on a
+ * connection with a congestion window, and retransmits lost segments
+ * after three duplicate acknowledgments instead of waiting for the
+ * retransmission timer. It only makes sense when more than one
+ * segment may be in flight (UIP_TCP_WINDOW_SEGMENTS > 1). The
+ * congestion avoidance algorithm is selected per connection; see the
+ * uip-cc module.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_CC
+#define UIP_TCP_CC UIP_CONF_TCP_CC
+#else /* UIP_CONF_TCP_CC */
+#define UIP_TCP_CC 0
+#endif /* UIP_CONF_TCP_CC */
+
+/**
+ * Determines if the TCP retransmission timeout should be measured
+ * with clock_time().
+ *
+ * By default, round-trip times and the retransmission timeout are
+ * counted in periodic timer ticks, so no retransmission timeout is
+ * shorter than one tick. If this option is set, the round-trip time
+ * is measured with clock_time() and the retransmission timeout is
+ * computed as specified by RFC6298, with Karn's algorithm. The
+ * retransmission timers are then checked with uip_rexmit_expired()
+ * and uip_periodic_rexmit().
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_CLOCK_RTO
+#define UIP_TCP_CLOCK_RTO UIP_CONF_TCP_CLOCK_RTO
+#else /* UIP_CONF_TCP_CLOCK_RTO */
+#define UIP_TCP_CLOCK_RTO 0
+#endif /* UIP_CONF_TCP_CLOCK_RTO */
+
+/**
+ * The lower bound of the retransmission timeout, in milliseconds.
+ *
+ * RFC6298 recommends one second, but on a local network a much
+ * smaller value makes recovery from lost segments faster. Only used
+ * if UIP_TCP_CLOCK_RTO is set.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_RTO_MIN
+#define UIP_TCP_RTO_MIN UIP_CONF_TCP_RTO_MIN
+#else /* UIP_CONF_TCP_RTO_MIN */
+#define UIP_TCP_RTO_MIN 200
+#endif /* UIP_CONF_TCP_RTO_MIN */
+
+/**
+ * The upper bound of the retransmission timeout, in milliseconds.
+ *
+ * Only used if UIP_TCP_CLOCK_RTO is set.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_RTO_MAX
+#define UIP_TCP_RTO_MAX UIP_CONF_TCP_RTO_MAX
+#else /* UIP_CONF_TCP_RTO_MAX */
+#define UIP_TCP_RTO_MAX 60000
+#endif /* UIP_CONF_TCP_RTO_MAX */
+
+/**
+ * The longest time that the acknowledgment of received TCP data may
+ * be delayed, in milliseconds, or 0 if acknowledgments should not be
+ * delayed.
+ *
+ * By default, uIP acknowledges every data segment as soon as the
+ * application has processed it. If this option is set, the
+ * acknowledgment of an in-order segment is held back, as described
+ * in RFC 1122, so that it can be sent together with the reply of the
+ * application or with the acknowledgment of the next segment. Every
+ * second segment is acknowledged at once, and so are segments that
+ * fill a hole in the sequence space. RFC 1122 requires the delay to
+ * be less than 500 ms.
+ *
+ * This option requires UIP_TCP_CLOCK_RTO, since the acknowledgments
+ * are sent when uip_periodic_rexmit() is called.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_DELAYED_ACK
+#define UIP_TCP_DELAYED_ACK UIP_CONF_TCP_DELAYED_ACK
+#else /* UIP_CONF_TCP_DELAYED_ACK */
+#define UIP_TCP_DELAYED_ACK 0
+#endif /* UIP_CONF_TCP_DELAYED_ACK */
+
 /**
  * How long a connection should stay in the TIME_WAIT state.
  *
@@ -327,6 +615,31 @@
  */
 #define UIP_TIME_WAIT_TIMEOUT 120
 
+/**
+ * The number of entries in the TIME_WAIT table.
+ *
+ * By default, a connection that is closed by uIP first stays in the
+ * TIME_WAIT state in its slot of the uip_conns table for
+ * UIP_TIME_WAIT_TIMEOUT periodic ticks. If this option is set to a
+ * non-zero value, the addresses, ports and sequence numbers of the
+ * connection are moved to a separate, much smaller table when it
+ * enters TIME_WAIT. Its slot in uip_conns is freed at once. Late
+ * segments for the connection are still acknowledged from the
+ * TIME_WAIT table. A new SYN with a higher sequence number opens a new
+ * connection (RFC 1122). When the table is full, the oldest entry is
+ * replaced.
+ *
+ * Without UIP_TCP_TIMER_WHEEL, the entries are aged when uip_periodic()
+ * is called for the first connection.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_TIME_WAIT_CONNS
+#define UIP_TCP_TIME_WAIT_CONNS UIP_CONF_TCP_TIME_WAIT_CONNS
+#else /* UIP_CONF_TCP_TIME_WAIT_CONNS */
+#define UIP_TCP_TIME_WAIT_CONNS 0
+#endif /* UIP_CONF_TCP_TIME_WAIT_CONNS */
+
 
 /** @} */
 /*------------------------------------------------------------------------------*/
@@ -381,6 +694,174 @@
 #define UIP_BUFSIZE UIP_CONF_BUFFER_SIZE
 #endif /* UIP_CONF_BUFFER_SIZE */
 
+/**
+ * The number of packet buffers in the packet buffer pool.
+ *
+ * If this is set to a non-zero value, uIP keeps a pool of packet
+ * buffers, each UIP_BUFSIZE bytes large, and uip_buf points to the
+ * buffer of the current packet instead of being a single global
+ * array. This lets the device driver read a batch of packets and
+ * queue outbound packets (see uip-packet.h). At least two buffers are
+ * needed for this to be of any use.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_PACKETS
+#define UIP_PACKETS UIP_CONF_PACKETS
+#else /* UIP_CONF_PACKETS */
+#define UIP_PACKETS 0
+#endif /* UIP_CONF_PACKETS */
+
+/**
+ * The maximum number of out-of-order segments queued per TCP
+ * connection.
+ *
+ * Normally, uIP drops every segment that does not start at the next
+ * expected sequence number, so the remote host has to retransmit all
+ * data that followed a lost segment. If this option is set to a
+ * non-zero value, segments that arrive ahead of a hole in the
+ * sequence space are instead copied into buffers from the packet
+ * buffer pool, and are delivered to the application in order once the
+ * missing segment has arrived (see uip_reorder_ready()). Two buffers
+ * of the pool are always left free for the device driver. Segments
+ * that do not fit in the queue are dropped, so UIP_RECEIVE_WINDOW
+ * should not be larger than UIP_TCP_REORDER + 1 segments.
+ *
+ * This option requires UIP_PACKETS.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_REORDER
+#define UIP_TCP_REORDER UIP_CONF_TCP_REORDER
+#else /* UIP_CONF_TCP_REORDER */
+#define UIP_TCP_REORDER 0
+#endif /* UIP_CONF_TCP_REORDER */
+
+/**
+ * Determines if TCP selective acknowledgments (RFC 2018) should be
+ * used.
+ *
+ * If this is set to a non-zero value, uIP offers the SACK-permitted
+ * option in its SYN and SYN-ACK segments. When the remote host agrees,
+ * every acknowledgment sent while segments are held in the
+ * out-of-order queue carries SACK blocks describing them, so the
+ * remote host only has to retransmit the missing data. With
+ * UIP_TCP_CC, the SACK blocks received from the remote host are used
+ * during loss recovery to retransmit only the segments that have not
+ * arrived.
+ *
+ * This option requires UIP_TCP_REORDER.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SACK
+#define UIP_TCP_SACK UIP_CONF_TCP_SACK
+#else /* UIP_CONF_TCP_SACK */
+#define UIP_TCP_SACK 0
+#endif /* UIP_CONF_TCP_SACK */
+
+/**
+ * The number of local ports handed out by uip_connect() and
+ * uip_udp_new().
+ *
+ * By default, uIP picks the next port in sequence and scans all
+ * connections to make sure the port is not already in use, starting
+ * over if it is. If this option is set to a non-zero value, the ports
+ * 4096 to 4096 + UIP_EPHEMERAL_PORTS - 1 are instead tracked in a
+ * bitmap that is shared by TCP and UDP, and a free port is picked at
+ * a random position in it (RFC 6056). The bitmap takes
+ * UIP_EPHEMERAL_PORTS / 8 bytes of memory, and the value cannot be
+ * larger than 27904.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_EPHEMERAL_PORTS
+#define UIP_EPHEMERAL_PORTS UIP_CONF_EPHEMERAL_PORTS
+#else /* UIP_CONF_EPHEMERAL_PORTS */
+#define UIP_EPHEMERAL_PORTS 0
+#endif /* UIP_CONF_EPHEMERAL_PORTS */
+
+/**
+ * Determines if the connection tables should be sized at run time.
+ *
+ * By default, the uip_conns, uip_udp_conns and listening port tables
+ * are static arrays of UIP_CONNS, UIP_UDP_CONNS and UIP_LISTENPORTS
+ * entries. If this option is set, the tables are allocated with
+ * malloc() by uip_settables(), which must be called before
+ * uip_init(). UIP_CONNS, UIP_UDP_CONNS and UIP_LISTENPORTS then
+ * evaluate to the number of entries that are in use at the beginning
+ * of each table. That number grows when a new entry is needed and,
+ * for TCP, shrinks when the last connection of the table is closed,
+ * so loops over the tables only visit the entries in use.
+ *
+ * This option is meant for hosted builds.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_DYNAMIC_TABLES
+#define UIP_DYNAMIC_TABLES UIP_CONF_DYNAMIC_TABLES
+#else /* UIP_CONF_DYNAMIC_TABLES */
+#define UIP_DYNAMIC_TABLES 0
+#endif /* UIP_CONF_DYNAMIC_TABLES */
+
+/**
+ * Determines if applications can send data without copying it.
+ *
+ * If this option is set, uip_sendref() can be used instead of
+ * uip_send() for data that stays in place until it has been
+ * acknowledged, such as constant file data. The data is not copied
+ * into uip_buf; instead uip_appdata is pointed at it and uip_reflen
+ * is set to its length, and the device driver transmits the headers
+ * from uip_buf and the data from uip_appdata. The checksum functions
+ * also sum the data where it is, so a port that provides its own
+ * checksum functions (UIP_ARCH_CHKSUM) must do the same.
+ *
+ * The data must stay in place until the driver has transmitted the
+ * packet, also if the driver queues packets and transmits them later.
+ * Data in uip_buf does not, and must be sent with uip_send().
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_ZEROCOPY
+#define UIP_ZEROCOPY UIP_CONF_ZEROCOPY
+#else /* UIP_CONF_ZEROCOPY */
+#define UIP_ZEROCOPY 0
+#endif /* UIP_CONF_ZEROCOPY */
+
+/**
+ * The number of TCP send buffers in the send buffer pool.
+ *
+ * Normally, uIP keeps no copy of the data it sends, so the
+ * application must wait for each segment to be acknowledged and must
+ * produce the same data again when it is to be retransmitted. If this
+ * option is set to a non-zero value, an application can give a
+ * connection a ring buffer from a pool of UIP_TCP_SENDBUFS buffers
+ * (see uip-sendbuf.h). Data written to the buffer is sent, and
+ * retransmitted, by uIP, so the application only has to wait when
+ * the buffer is full.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SENDBUFS
+#define UIP_TCP_SENDBUFS UIP_CONF_TCP_SENDBUFS
+#else /* UIP_CONF_TCP_SENDBUFS */
+#define UIP_TCP_SENDBUFS 0
+#endif /* UIP_CONF_TCP_SENDBUFS */
+
+/**
+ * The size of each TCP send buffer, in bytes.
+ *
+ * A buffer must hold at least one full segment, and should hold as
+ * many segments as are to be in flight at the same time.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SENDBUF_SIZE
+#define UIP_TCP_SENDBUF_SIZE UIP_CONF_TCP_SENDBUF_SIZE
+#else /* UIP_CONF_TCP_SENDBUF_SIZE */
+#define UIP_TCP_SENDBUF_SIZE (4 * UIP_TCP_MSS)
+#endif /* UIP_CONF_TCP_SENDBUF_SIZE */
+
 
 /**
  * Determines if statistics support should be compiled in.
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+/**
+ * \file
+ *         Unit checks of the TCP congestion control
+ *
+ *         The functions that uip.c calls on acknowledgments, duplicate
+ *         acknowledgments and retransmission timeouts are driven with
+ *         a connection structure that is set up by hand, and the
+ *         resulting congestion control state is checked.
+ */
+
+#include "uip-cc.h"
+#include "clock.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MSS 1000
+
+static clock_time_t now;
+static int failures;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+/*---------------------------------------------------------------------------*/
+clock_time_t
+clock_time(void)
+{
+  return now;
+}
+/*---------------------------------------------------------------------------*/
+static void
+check(int ok, const char *cond, int line)
+{
+  if(!ok) {
+    printf("cc-test.c:%d: check failed: %s\n", line, cond);
+    ++failures;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Sets up an established connection with len bytes in flight, a
+   congestion window of cwnd bytes, and congestion avoidance. */
+static void
+setup(struct uip_conn *conn, const struct uip_cc *cc, u16_t cwnd, u16_t len)
+{
+  memset(conn, 0, sizeof(*conn));
+  conn->initialmss = conn->mss = MSS;
+  uip_cc_init(conn);
+  conn->cc = cc;
+  cc->init(conn);
+  conn->cwnd = cwnd;
+  conn->ssthresh = cwnd;
+  conn->len = len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_init(void)
+{
+  struct uip_conn conn;
+
+  /* RFC 3390: min(4 * MSS, max(2 * MSS, 4380 bytes)). */
+  memset(&conn, 0, sizeof(conn));
+  conn.initialmss = conn.mss = 536;
+  uip_cc_init(&conn);
+  CHECK(conn.cwnd == 4 * 536);
+  conn.initialmss = conn.mss = 1460;
+  uip_cc_init(&conn);
+  CHECK(conn.cwnd == 4380);
+  conn.initialmss = conn.mss = 3000;
+  uip_cc_init(&conn);
+  CHECK(conn.cwnd == 6000);
+  CHECK(conn.ssthresh == 0xffff);
+  CHECK(conn.recovery == 0 && conn.dupacks == 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_slow_start(void)
+{
+  struct uip_conn conn;
+
+  setup(&conn, &uip_cc_newreno, 4 * MSS, 4 * MSS);
+  conn.ssthresh = 0xffff;
+
+  /* One segment per acknowledgment, also if it acknowledges more. */
+  CHECK(uip_cc_ack(&conn, MSS) == 0);
+  CHECK(conn.cwnd == 5 * MSS);
+  CHECK(uip_cc_ack(&conn, 3 * MSS) == 0);
+  CHECK(conn.cwnd == 6 * MSS);
+  CHECK(uip_cc_ack(&conn, MSS / 2) == 0);
+  CHECK(conn.cwnd == 6 * MSS + MSS / 2);
+
+  /* The window saturates instead of wrapping around. */
+  conn.cwnd = 0xffff - 10;
+  uip_cc_ack(&conn, MSS);
+  CHECK(conn.cwnd == 0xffff);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_cong_avoid(void)
+{
+  struct uip_conn conn;
+  int i;
+
+  /* NewReno grows by about one segment per window of data. */
+  setup(&conn, &uip_cc_newreno, 10 * MSS, 10 * MSS);
+  for(i = 0; i < 10; ++i) {
+    uip_cc_ack(&conn, MSS);
+  }
+  CHECK(conn.cwnd >= 10 * MSS + MSS - 100 && conn.cwnd <= 11 * MSS);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_fast_retransmit(const struct uip_cc *cc, u16_t ssthresh)
+{
+  struct uip_conn conn;
+
+  setup(&conn, cc, 20 * MSS, 20 * MSS);
+
+  /* Nothing happens before the third duplicate acknowledgment. */
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(conn.cwnd == 20 * MSS && conn.recovery == 0);
+
+  /* The third one triggers a fast retransmit, and the window is set
+     to ssthresh plus the three segments that have left the
+     network. */
+  CHECK(uip_cc_dupack(&conn) == 1);
+  CHECK(conn.ssthresh == ssthresh);
+  CHECK(conn.cwnd == ssthresh + 3 * MSS);
+  CHECK(conn.recover == 20 * MSS);
+  CHECK(conn.recovery != 0);
+
+  /* Further duplicates inflate the window without retransmitting. */
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(conn.cwnd == ssthresh + 5 * MSS);
+
+  /* A partial acknowledgment retransmits the next hole, deflates the
+     window by the acknowledged data, adds back one segment, and
+     moves recover along. */
+  conn.len -= 2 * MSS;
+  CHECK(uip_cc_ack(&conn, 2 * MSS) == 1);
+  CHECK(conn.cwnd == ssthresh + 5 * MSS - 2 * MSS + MSS);
+  CHECK(conn.recover == 18 * MSS);
+  CHECK(conn.recovery != 0);
+  CHECK(conn.dupacks == 0);
+
+  /* Duplicates after a partial acknowledgment still inflate. */
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(conn.cwnd == ssthresh + 5 * MSS);
+
+  /* The acknowledgment of everything up to recover ends the
+     recovery, with the window deflated to ssthresh. */
+  conn.len -= 18 * MSS;
+  conn.len += 16 * MSS;
+  CHECK(uip_cc_ack(&conn, 18 * MSS) == 0);
+  CHECK(conn.recovery == 0);
+  CHECK(conn.cwnd == ssthresh);
+
+  /* The window is not set above what is in flight plus a segment. */
+  setup(&conn, cc, 20 * MSS, 20 * MSS);
+  uip_cc_dupack(&conn);
+  uip_cc_dupack(&conn);
+  uip_cc_dupack(&conn);
+  conn.len = 0;
+  CHECK(uip_cc_ack(&conn, 20 * MSS) == 0);
+  CHECK(conn.cwnd == MSS);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_dupack_reset(void)
+{
+  struct uip_conn conn;
+
+  /* New data acknowledged between duplicates starts the count
+     over. */
+  setup(&conn, &uip_cc_newreno, 10 * MSS, 10 * MSS);
+  uip_cc_dupack(&conn);
+  uip_cc_dupack(&conn);
+  conn.len -= MSS;
+  uip_cc_ack(&conn, MSS);
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(conn.recovery == 0);
+  CHECK(uip_cc_dupack(&conn) == 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_ssthresh_floor(const struct uip_cc *cc)
+{
+  struct uip_conn conn;
+
+  /* With little in flight, ssthresh does not go below two
+     segments. */
+  setup(&conn, cc, 2 * MSS, 2 * MSS);
+  uip_cc_dupack(&conn);
+  uip_cc_dupack(&conn);
+  CHECK(uip_cc_dupack(&conn) == 1);
+  CHECK(conn.ssthresh == 2 * MSS);
+  CHECK(conn.cwnd == 5 * MSS);
+
+  setup(&conn, cc, MSS, MSS);
+  uip_cc_timeout(&conn);
+  CHECK(conn.ssthresh == 2 * MSS);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_timeout(void)
+{
+  struct uip_conn conn;
+
+  setup(&conn, &uip_cc_newreno, 16 * MSS, 16 * MSS);
+  uip_cc_dupack(&conn);
+  uip_cc_timeout(&conn);
+  CHECK(conn.ssthresh == 8 * MSS);
+  CHECK(conn.cwnd == MSS);
+  CHECK(conn.recover == 16 * MSS);
+  CHECK(conn.dupacks == 0);
+
+  /* A second timeout of the same segment keeps ssthresh. */
+  uip_cc_timeout(&conn);
+  CHECK(conn.ssthresh == 8 * MSS);
+  CHECK(conn.cwnd == MSS);
+
+  /* Duplicates do not start a fast retransmit during the recovery
+     from a timeout. */
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(uip_cc_dupack(&conn) == 0);
+  CHECK(conn.cwnd == MSS);
+
+  /* Partial acknowledgments retransmit the next segment, and the
+     window grows by slow start. */
+  conn.len -= MSS;
+  CHECK(uip_cc_ack(&conn, MSS) == 1);
+  CHECK(conn.cwnd == 2 * MSS);
+  CHECK(conn.recover == 15 * MSS);
+
+  /* Once everything is acknowledged the recovery ends, and the
+     window is kept. */
+  conn.len = 0;
+  CHECK(uip_cc_ack(&conn, 15 * MSS) == 0);
+  CHECK(conn.recovery == 0);
+  CHECK(conn.cwnd == 2 * MSS);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_cubic(void)
+{
+  struct uip_conn conn;
+  u16_t prev;
+  int i;
+
+  /* After a loss at 40 segments, the window grows back towards
+     W_max, slows down close to it, and passes it later on. */
+  setup(&conn, &uip_cc_cubic, 40 * MSS, 40 * MSS);
+  now = CLOCK_SECOND;
+  uip_cc_dupack(&conn);
+  uip_cc_dupack(&conn);
+  uip_cc_dupack(&conn);
+  CHECK(conn.ssthresh == 28 * MSS);
+  conn.len = 0;
+  uip_cc_ack(&conn, 40 * MSS);
+  CHECK(conn.cwnd == MSS);
+  conn.cwnd = conn.ssthresh;
+
+  prev = conn.cwnd;
+  for(i = 0; i < 100; ++i) {
+    now += CLOCK_SECOND / 20;
+    uip_cc_ack(&conn, MSS);
+    CHECK(conn.cwnd >= prev);
+    prev = conn.cwnd;
+  }
+  CHECK(conn.cwnd > 28 * MSS);
+  for(i = 0; i < 400; ++i) {
+    now += CLOCK_SECOND / 20;
+    uip_cc_ack(&conn, MSS);
+  }
+  CHECK(conn.cwnd > 40 * MSS);
+
+  /* Fast convergence: a loss below the previous W_max lowers it. */
+  setup(&conn, &uip_cc_cubic, 40 * MSS, 40 * MSS);
+  conn.ccstate[0] = 50 * MSS;
+  uip_cc_timeout(&conn);
+  CHECK(conn.ccstate[0] == 40 * MSS * 17 / 20);
+  CHECK(conn.ssthresh == 28 * MSS);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+  test_init();
+  test_slow_start();
+  test_cong_avoid();
+  test_fast_retransmit(&uip_cc_newreno, 10 * MSS);
+  test_fast_retransmit(&uip_cc_cubic, 14 * MSS);
+  test_dupack_reset();
+  test_ssthresh_floor(&uip_cc_newreno);
+  test_ssthresh_floor(&uip_cc_cubic);
+  test_timeout();
+  test_cubic();
+
+  if(failures > 0) {
+    printf("cc-test: %d checks failed\n", failures);
+    return 1;
+  }
+  printf("cc-test: ok\n");
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
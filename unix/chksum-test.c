@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+/**
+ * \file
+ *         Differential test and benchmark of the checksum functions
+ *
+ *         The checksum functions in uip_arch.c are compared with the
+ *         generic checksum routine of uip.c over all lengths up to a
+ *         full frame and all alignments within a 32-byte vector, once
+ *         for each implementation that the CPU supports. With the -b
+ *         option, the throughput of each implementation is measured.
+ */
+
+#include "uip_arch.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_LEN    2100
+#define ALIGNMENTS 32
+
+/* uip_arch.c refers to these, which otherwise come with uip.c. */
+u8_t uip_buf[UIP_BUFSIZE + 2];
+void *uip_appdata;
+#if UIP_ZEROCOPY
+u16_t uip_reflen, uip_refsum, uip_refsumlen;
+#endif /* UIP_ZEROCOPY */
+
+u16_t
+htons(u16_t val)
+{
+  return HTONS(val);
+}
+
+struct impl {
+  const char *name;
+  uint64_t (* sum)(const u8_t *data, u16_t len);
+};
+
+static const struct impl impls[] = {
+  {"scalar", sum_scalar},
+#ifdef __SSE2__
+  {"sse2", sum_sse2},
+#endif /* __SSE2__ */
+#if HAVE_AVX2
+  {"avx2", sum_avx2},
+#endif /* HAVE_AVX2 */
+};
+
+#define NIMPLS (sizeof(impls) / sizeof(impls[0]))
+
+static u8_t data[MAX_LEN + ALIGNMENTS];
+
+/*---------------------------------------------------------------------------*/
+/* The generic checksum routine of uip.c, which is not compiled in when
+   UIP_ARCH_CHKSUM is set. */
+static u16_t
+ref_chksum(u16_t sum, const u8_t *data, u16_t len)
+{
+  u16_t t;
+  const u8_t *dataptr;
+  const u8_t *last_byte;
+
+  dataptr = data;
+  last_byte = data + len - 1;
+
+  while(dataptr < last_byte) {
+    t = (dataptr[0] << 8) + dataptr[1];
+    sum += t;
+    if(sum < t) {
+      sum++;
+    }
+    dataptr += 2;
+  }
+
+  if(dataptr == last_byte) {
+    t = (dataptr[0] << 8) + 0;
+    sum += t;
+    if(sum < t) {
+      sum++;
+    }
+  }
+
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+static int
+supported(const struct impl *impl)
+{
+#if HAVE_AVX2
+  if(impl->sum == sum_avx2) {
+    return __builtin_cpu_supports("avx2");
+  }
+#endif /* HAVE_AVX2 */
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+fill(int pattern)
+{
+  unsigned int i;
+
+  for(i = 0; i < sizeof(data); ++i) {
+    switch(pattern) {
+    case 0:
+      data[i] = rand();
+      break;
+    case 1:
+      /* Every word is 0xffff, so every addition carries. */
+      data[i] = 0xff;
+      break;
+    default:
+      data[i] = 0;
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+test(void)
+{
+  const struct impl *impl;
+  unsigned int align, len;
+  int pattern, errors, failed;
+  u16_t want, got;
+
+  errors = 0;
+  for(impl = &impls[0]; impl < &impls[NIMPLS]; ++impl) {
+    if(!supported(impl)) {
+      printf("%-8s not supported by this CPU\n", impl->name);
+      continue;
+    }
+    sum_vector = impl->sum;
+    failed = errors;
+    for(pattern = 0; pattern < 3; ++pattern) {
+      fill(pattern);
+      for(align = 0; align < ALIGNMENTS; ++align) {
+	for(len = 0; len <= MAX_LEN; ++len) {
+	  want = htons(ref_chksum(0, &data[align], len));
+	  got = uip_chksum((u16_t *)&data[align], len);
+	  if(got != want) {
+	    if(errors < 10) {
+	      printf("%s: length %u alignment %u pattern %d: "
+		     "0x%04x, expected 0x%04x\n",
+		     impl->name, len, align, pattern, got, want);
+	    }
+	    ++errors;
+	  }
+	}
+      }
+    }
+    printf("%-8s %s\n", impl->name, errors > failed? "FAILED": "ok");
+  }
+  return errors;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench(void)
+{
+  static const u16_t lens[] = {20, 40, 576, 1460};
+  const struct impl *impl;
+  unsigned int i, n, rounds;
+  volatile u16_t sink;
+  double t;
+
+  fill(0);
+  for(i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i) {
+    rounds = 200000000 / (lens[i] + 64);
+    t = now();
+    for(n = 0; n < rounds; ++n) {
+      sink = ref_chksum(0, data, lens[i]);
+    }
+    t = now() - t;
+    printf("%4u bytes  %-8s %8.1f MB/s\n", lens[i], "generic",
+	   (double)rounds * lens[i] / t / 1e6);
+    for(impl = &impls[0]; impl < &impls[NIMPLS]; ++impl) {
+      if(!supported(impl)) {
+	continue;
+      }
+      sum_vector = impl->sum;
+      t = now();
+      for(n = 0; n < rounds; ++n) {
+	sink = uip_chksum((u16_t *)data, lens[i]);
+      }
+      t = now() - t;
+      printf("%4u bytes  %-8s %8.1f MB/s\n", lens[i], impl->name,
+	     (double)rounds * lens[i] / t / 1e6);
+    }
+  }
+  (void)sink;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char *argv[])
+{
+  if(test() != 0) {
+    return 1;
+  }
+  if(argc > 1 && strcmp(argv[1], "-b") == 0) {
+    bench();
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
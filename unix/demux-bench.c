@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of the demultiplexing of incoming TCP segments
+ *
+ *         The benchmark opens 10 to 10000 connections to a listening
+ *         port through uip_input(), and then measures the time
+ *         uip_input() takes for an acknowledgment to a random one of
+ *         them. The acknowledgment carries nothing new, so it is
+ *         dropped once it has been matched to its connection and the
+ *         time is mostly that of the lookup. It is built with the
+ *         connection tables allocated at run time, once with
+ *         UIP_CONF_TCP_HASH and once without.
+ */
+
+#include "uip.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BUF ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+#define TCP_SYN 0x02
+#define TCP_ACK 0x10
+
+#define PORT    80
+#define FRAMES  1024
+
+struct frame {
+  u8_t buf[UIP_LLH_LEN + UIP_TCPIP_HLEN];
+};
+
+static struct frame frames[FRAMES];
+
+/* The port that each remote host connects from. */
+static u16_t *ports;
+
+/*---------------------------------------------------------------------------*/
+/* The connections only have to exist, so the application does
+   nothing. */
+void
+httpd_appcall(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_log(char *m)
+{
+  fprintf(stderr, "uip: %s\n", m);
+}
+/*---------------------------------------------------------------------------*/
+static void
+put32(u8_t *p, unsigned long v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+get32(const u8_t *p)
+{
+  return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16) |
+    ((unsigned long)p[2] << 8) | p[3];
+}
+/*---------------------------------------------------------------------------*/
+/* Puts a segment from remote host number i into uip_buf. */
+static void
+segment(unsigned int i, u8_t flags, unsigned long seq, unsigned long ack)
+{
+  memset(uip_buf, 0, UIP_LLH_LEN + UIP_TCPIP_HLEN);
+  BUF->vhl = 0x45;
+  BUF->len[1] = UIP_TCPIP_HLEN;
+  BUF->ttl = 64;
+  BUF->proto = UIP_PROTO_TCP;
+  uip_ipaddr(BUF->srcipaddr, 10, 0, (i + 1) >> 8, (i + 1) & 0xff);
+  uip_ipaddr(BUF->destipaddr, 192, 168, 0, 2);
+  BUF->srcport = ports[i];
+  BUF->destport = HTONS(PORT);
+  put32(BUF->seqno, seq);
+  put32(BUF->ackno, ack);
+  BUF->tcpoffset = 5 << 4;
+  BUF->flags = flags;
+  BUF->wnd[0] = 0x20;
+  BUF->ipchksum = 0;
+  BUF->ipchksum = ~(uip_ipchksum());
+  BUF->tcpchksum = 0;
+  BUF->tcpchksum = ~(uip_tcpchksum());
+  uip_len = UIP_LLH_LEN + UIP_TCPIP_HLEN;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static int
+run(unsigned int nconns)
+{
+  struct uip_tables tables;
+  uip_ipaddr_t addr;
+  unsigned long *snd;
+  unsigned int i, n, rounds;
+  double t;
+
+  tables.conns = nconns;
+  tables.listenports = 1;
+  tables.udp_conns = 0;
+  if(!uip_settables(&tables)) {
+    fprintf(stderr, "cannot allocate %u connections\n", nconns);
+    return 1;
+  }
+  uip_init();
+  uip_ipaddr(addr, 192, 168, 0, 2);
+  uip_sethostaddr(addr);
+  uip_listen(HTONS(PORT));
+
+  /* Open the connections, from random ports as a client would. */
+  srand(1);
+  snd = malloc(nconns * sizeof(unsigned long));
+  ports = malloc(nconns * sizeof(u16_t));
+  for(i = 0; i < nconns; ++i) {
+    ports[i] = htons(1024 + rand() % 60000);
+    segment(i, TCP_SYN, 1000, 0);
+    uip_input();
+    if(uip_len == 0 || BUF->flags != (TCP_SYN | TCP_ACK)) {
+      fprintf(stderr, "connection %u was not accepted\n", i);
+      return 1;
+    }
+    snd[i] = get32(BUF->seqno) + 1;
+    segment(i, TCP_ACK, 1001, snd[i]);
+    uip_input();
+  }
+
+  /* Prepare acknowledgments to random connections. */
+  for(n = 0; n < FRAMES; ++n) {
+    i = rand() % nconns;
+    segment(i, TCP_ACK, 1001, snd[i]);
+    memcpy(frames[n].buf, uip_buf, sizeof(frames[n].buf));
+  }
+  free(snd);
+  free(ports);
+
+  rounds = 0;
+  t = now();
+  do {
+    for(n = 0; n < FRAMES; ++n) {
+      memcpy(uip_buf, frames[n].buf, sizeof(frames[n].buf));
+      uip_len = sizeof(frames[n].buf);
+      uip_input();
+      if(uip_len != 0) {
+	/* A segment that matches no connection is answered with a
+	   RST. */
+	fprintf(stderr, "segment %u was not demultiplexed\n", n);
+	return 1;
+      }
+    }
+    rounds += FRAMES;
+  } while(now() - t < 0.5);
+  t = now() - t;
+
+  printf("%5u connections  %8.1f ns per segment\n", nconns,
+	 t / rounds * 1e9);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+  static const unsigned int nconns[] = {10, 100, 1000, 10000};
+  unsigned int i;
+
+#if UIP_TCP_HASH
+  printf("hashed lookup, %u buckets\n", UIP_TCP_HASH_SIZE);
+#else /* UIP_TCP_HASH */
+  printf("linear lookup\n");
+#endif /* UIP_TCP_HASH */
+  for(i = 0; i < sizeof(nconns) / sizeof(nconns[0]); ++i) {
+    if(run(nconns[i]) != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
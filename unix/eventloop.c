@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+/**
+ * \file
+ *         Event loop for the unix port
+ *
+ *         On Linux, the event loop waits in epoll_wait() with a
+ *         timerfd for the timeout, so that the process only wakes up
+ *         when a packet has arrived or a timer is due. On other
+ *         systems, select() is used.
+ */
+
+#include "eventloop.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+
+#ifdef linux
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#else /* linux */
+#include <sys/select.h>
+#endif /* linux */
+
+#ifdef EVENTLOOP_CONF_FDS
+#define EVENTLOOP_FDS EVENTLOOP_CONF_FDS
+#else /* EVENTLOOP_CONF_FDS */
+#define EVENTLOOP_FDS 8
+#endif /* EVENTLOOP_CONF_FDS */
+
+struct watch {
+  int fd;
+  eventloop_handler_t handler;
+  void *ptr;
+};
+
+static struct watch watches[EVENTLOOP_FDS];
+
+#ifdef linux
+static int epfd, tfd;
+#endif /* linux */
+
+/*---------------------------------------------------------------------------*/
+void
+eventloop_init(void)
+{
+#ifdef linux
+  struct epoll_event ev;
+#endif /* linux */
+  int i;
+
+  for(i = 0; i < EVENTLOOP_FDS; ++i) {
+    watches[i].fd = -1;
+  }
+
+#ifdef linux
+  epfd = epoll_create1(0);
+  if(epfd == -1) {
+    perror("eventloop: eventloop_init: epoll_create1");
+    exit(1);
+  }
+  tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+  if(tfd == -1) {
+    perror("eventloop: eventloop_init: timerfd_create");
+    exit(1);
+  }
+
+  /* The timer is told apart from the watched file descriptors by its
+     NULL data pointer. */
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  if(epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &ev) == -1) {
+    perror("eventloop: eventloop_init: epoll_ctl");
+    exit(1);
+  }
+#endif /* linux */
+}
+/*---------------------------------------------------------------------------*/
+int
+eventloop_add(int fd, eventloop_handler_t handler, void *ptr)
+{
+#ifdef linux
+  struct epoll_event ev;
+#endif /* linux */
+  struct watch *w;
+
+  for(w = &watches[0]; w < &watches[EVENTLOOP_FDS]; ++w) {
+    if(w->fd == -1) {
+#ifdef linux
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN;
+      ev.data.ptr = w;
+      if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+	return -1;
+      }
+#endif /* linux */
+      w->fd = fd;
+      w->handler = handler;
+      w->ptr = ptr;
+      return 0;
+    }
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+void
+eventloop_remove(int fd)
+{
+  struct watch *w;
+
+  for(w = &watches[0]; w < &watches[EVENTLOOP_FDS]; ++w) {
+    if(w->fd == fd) {
+#ifdef linux
+      epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+#endif /* linux */
+      w->fd = -1;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+#ifdef linux
+void
+eventloop_wait(clock_time_t timeout)
+{
+  struct epoll_event events[EVENTLOOP_FDS + 1];
+  struct itimerspec its;
+  struct watch *w;
+  uint64_t expirations;
+  int i, n;
+
+  /* Arm the timer, or disarm it if there is no timeout. An all-zero
+     it_value disarms the timer, so a timeout of zero is handled as a
+     poll by epoll_wait() instead. */
+  if(timeout != 0) {
+    memset(&its, 0, sizeof(its));
+    if(timeout > 0) {
+      its.it_value.tv_sec = timeout / CLOCK_SECOND;
+      its.it_value.tv_nsec = (long)(timeout % CLOCK_SECOND) *
+	(1000000000L / CLOCK_SECOND);
+    }
+    timerfd_settime(tfd, 0, &its, NULL);
+  }
+
+  n = epoll_wait(epfd, events, EVENTLOOP_FDS + 1, timeout == 0? 0: -1);
+
+  for(i = 0; i < n; ++i) {
+    w = events[i].data.ptr;
+    if(w == NULL) {
+      read(tfd, &expirations, sizeof(expirations));
+    } else if(w->fd != -1 && w->handler != NULL) {
+      w->handler(w->fd, w->ptr);
+    }
+  }
+}
+#else /* linux */
+void
+eventloop_wait(clock_time_t timeout)
+{
+  fd_set fdset;
+  struct timeval tv;
+  struct watch *w;
+  int maxfd;
+
+  FD_ZERO(&fdset);
+  maxfd = -1;
+  for(w = &watches[0]; w < &watches[EVENTLOOP_FDS]; ++w) {
+    if(w->fd != -1) {
+      FD_SET(w->fd, &fdset);
+      if(w->fd > maxfd) {
+	maxfd = w->fd;
+      }
+    }
+  }
+
+  tv.tv_sec = timeout / CLOCK_SECOND;
+  tv.tv_usec = (long)(timeout % CLOCK_SECOND) * (1000000L / CLOCK_SECOND);
+
+  if(select(maxfd + 1, &fdset, NULL, NULL, timeout < 0? NULL: &tv) <= 0) {
+    return;
+  }
+
+  for(w = &watches[0]; w < &watches[EVENTLOOP_FDS]; ++w) {
+    if(w->fd != -1 && FD_ISSET(w->fd, &fdset) && w->handler != NULL) {
+      w->handler(w->fd, w->ptr);
+    }
+  }
+}
+#endif /* linux */
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+#ifndef __EVENTLOOP_H__
+#define __EVENTLOOP_H__
+
+#include "clock.h"
+
+/* The event loop of the unix port. The main loop sleeps in
+   eventloop_wait() until one of the file descriptors that have been
+   added with eventloop_add() becomes readable, or until the timeout,
+   which should be the time until the next uIP timer is due. */
+
+typedef void (* eventloop_handler_t)(int fd, void *ptr);
+
+void eventloop_init(void);
+
+/* Watch a file descriptor. The handler, which may be NULL, is called
+   from eventloop_wait() when the file descriptor is readable. Returns
+   0, or -1 if the descriptor could not be added. */
+int eventloop_add(int fd, eventloop_handler_t handler, void *ptr);
+void eventloop_remove(int fd);
+
+/* Wait until a file descriptor is readable or until the timeout has
+   passed. A timeout of zero only polls the file descriptors, and a
+   negative timeout waits without a time limit. */
+void eventloop_wait(clock_time_t timeout);
+
+#endif /* __EVENTLOOP_H__ */
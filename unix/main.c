@@ -39,28 +39,172 @@
 #include "uip.h"
 #include "uip_arp.h"
 #include "tapdev.h"
+#include "eventloop.h"
 
 #include "timer.h"
 
+#if UIP_PACKETS > 1
+#include "uip-packet.h"
+#endif /* UIP_PACKETS > 1 */
+
+#if UIP_TCP_SYNCOOKIES
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#endif /* UIP_TCP_SYNCOOKIES */
+
+#if UIP_DYNAMIC_TABLES
+#include <stdio.h>
+#include <stdlib.h>
+#endif /* UIP_DYNAMIC_TABLES */
+
 #define BUF ((struct uip_eth_hdr *)&uip_buf[0])
 
 #ifndef NULL
 #define NULL (void *)0
 #endif /* NULL */
 
+#if UIP_PACKETS > 1
+static struct uip_packet_queue rxq, txq;
+
+/*---------------------------------------------------------------------------*/
+static void
+flush(void)
+{
+  struct uip_packet *cur, *p;
+
+  /* Transmit the queued packets, and then return to the current
+     packet, which may hold a packet that has not been queued. */
+  cur = uip_packet;
+  cur->len = uip_len;
+#if UIP_ZEROCOPY
+  cur->appdata = uip_appdata;
+  cur->reflen = uip_reflen;
+#endif /* UIP_ZEROCOPY */
+  while((p = uip_packet_dequeue(&txq)) != NULL) {
+    uip_packet_select(p);
+    tapdev_send();
+    uip_packet_free(p);
+  }
+  uip_packet_select(cur);
+}
+/*---------------------------------------------------------------------------*/
+static void
+output(void)
+{
+  struct uip_packet *p;
+
+  /* Queue the packet for transmission at the end of the main loop
+     iteration. If there are no free packet buffers, the queue is
+     flushed and the packet is sent right away. */
+  p = uip_packet_detach();
+  if(p != NULL) {
+    uip_packet_enqueue(&txq, p);
+  } else {
+    flush();
+    tapdev_send();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(void)
+{
+  struct uip_packet *p;
+
+  /* Read the frames that are waiting into a batch of packet buffers,
+     and then make the first one the current packet. One buffer is
+     kept free so that a reply can be queued. */
+  if(rxq.head == NULL) {
+    while(uip_packet_avail() > 0) {
+      uip_len = tapdev_read();
+      if(uip_len == 0) {
+	break;
+      }
+      uip_packet_enqueue(&rxq, uip_packet_detach());
+      if(uip_packet_avail() < 2 || !tapdev_poll()) {
+	break;
+      }
+    }
+  }
+
+  p = uip_packet_dequeue(&rxq);
+  if(p != NULL) {
+    uip_packet_free(uip_packet);
+    uip_packet_select(p);
+  } else {
+    uip_len = 0;
+  }
+}
+#else /* UIP_PACKETS > 1 */
+#define input()  (uip_len = tapdev_read())
+#define output() tapdev_send()
+#endif /* UIP_PACKETS > 1 */
+#if UIP_TCP_SYNCOOKIES
+/*---------------------------------------------------------------------------*/
+static unsigned long
+cookie_secret(void)
+{
+  unsigned long secret;
+  int fd;
+
+  fd = open("/dev/urandom", O_RDONLY);
+  if(fd != -1) {
+    if(read(fd, &secret, sizeof(secret)) == sizeof(secret)) {
+      close(fd);
+      return secret;
+    }
+    close(fd);
+  }
+
+  /* The time and process ID can be guessed, so this is only a last
+     resort. */
+  return (unsigned long)time(NULL) ^ ((unsigned long)getpid() << 16);
+}
+#endif /* UIP_TCP_SYNCOOKIES */
 /*---------------------------------------------------------------------------*/
 int
 main(void)
 {
+#if !UIP_TCP_TIMER_WHEEL || UIP_UDP || UIP_TCP_CLOCK_RTO
   int i;
+#endif /* !UIP_TCP_TIMER_WHEEL || UIP_UDP || UIP_TCP_CLOCK_RTO */
+  int idle;
   uip_ipaddr_t ipaddr;
   struct timer periodic_timer, arp_timer;
+#if UIP_TCP_TIMER_WHEEL
+  struct uip_conn *conn;
+#endif /* UIP_TCP_TIMER_WHEEL */
 
   timer_set(&periodic_timer, CLOCK_SECOND / 2);
   timer_set(&arp_timer, CLOCK_SECOND * 10);
   
   tapdev_init();
+#if UIP_DYNAMIC_TABLES
+  {
+    struct uip_tables tables;
+    char *s;
+
+    /* The number of TCP connections can be set in the environment. */
+    tables.conns = UIP_CONF_MAX_CONNECTIONS;
+    s = getenv("UIP_CONNS");
+    if(s != NULL) {
+      tables.conns = atoi(s);
+    }
+    tables.listenports = UIP_CONF_MAX_LISTENPORTS;
+    tables.udp_conns = 10;
+    if(!uip_settables(&tables)) {
+      fprintf(stderr, "uip: cannot allocate the connection tables\n");
+      exit(1);
+    }
+  }
+#endif /* UIP_DYNAMIC_TABLES */
   uip_init();
+#if UIP_TCP_SYNCOOKIES
+  uip_setcookiesecret(cookie_secret());
+#endif /* UIP_TCP_SYNCOOKIES */
+
+  eventloop_init();
+  eventloop_add(tapdev_fd(), NULL, NULL);
 
   uip_ipaddr(ipaddr, 192,168,0,2);
   uip_sethostaddr(ipaddr);
@@ -96,7 +240,8 @@ main(void)
 
   
   while(1) {
-    uip_len = tapdev_read();
+    input();
+    idle = uip_len == 0;
     if(uip_len > 0) {
       if(BUF->type == htons(UIP_ETHTYPE_IP)) {
 	uip_arp_ipin();
@@ -106,7 +251,30 @@ main(void)
 	   uip_len is set to a value > 0. */
 	if(uip_len > 0) {
 	  uip_arp_out();
-	  tapdev_send();
+	  output();
+#if UIP_TCP_REORDER
+	  /* Deliver the segments that were received out of order and
+	     now follow the data that was just received. */
+	  while(uip_conn != NULL && uip_reorder_ready(uip_conn)) {
+	    uip_reorder_conn(uip_conn);
+	    if(uip_len > 0) {
+	      uip_arp_out();
+	      output();
+	    }
+	  }
+#endif /* UIP_TCP_REORDER */
+#if UIP_TCP_WINDOW_SEGMENTS > 1
+	  /* Let the application fill up the rest of the send window
+	     of the connection. */
+	  while(uip_conn != NULL && uip_sendroom(uip_conn) > 0) {
+	    uip_poll_conn(uip_conn);
+	    if(uip_len == 0) {
+	      break;
+	    }
+	    uip_arp_out();
+	    output();
+	  }
+#endif /* UIP_TCP_WINDOW_SEGMENTS > 1 */
 	}
       } else if(BUF->type == htons(UIP_ETHTYPE_ARP)) {
 	uip_arp_arpin();
@@ -114,12 +282,38 @@ main(void)
 	   should be sent out on the network, the global variable
 	   uip_len is set to a value > 0. */
 	if(uip_len > 0) {
-	  tapdev_send();
+	  output();
 	}
       }
+    }
 
-    } else if(timer_expired(&periodic_timer)) {
+    /* The timers are checked on every iteration, so that they keep
+       running while packets arrive back to back. */
+#if UIP_TCP_CLOCK_RTO
+    if(uip_rexmit_expired()) {
+      for(i = 0; i < UIP_CONNS; i++) {
+	uip_periodic_rexmit(i);
+	if(uip_len > 0) {
+	  uip_arp_out();
+	  output();
+	}
+      }
+    }
+#endif /* UIP_TCP_CLOCK_RTO */
+    if(timer_expired(&periodic_timer)) {
       timer_reset(&periodic_timer);
+#if UIP_TCP_TIMER_WHEEL
+      /* Only the connections with a timer that is due are
+	 processed. */
+      uip_periodic_tick();
+      while((conn = uip_periodic_due()) != NULL) {
+	uip_periodic_conn(conn);
+	if(uip_len > 0) {
+	  uip_arp_out();
+	  output();
+	}
+      }
+#else /* UIP_TCP_TIMER_WHEEL */
       for(i = 0; i < UIP_CONNS; i++) {
 	uip_periodic(i);
 	/* If the above function invocation resulted in data that
@@ -127,9 +321,10 @@ main(void)
 	   uip_len is set to a value > 0. */
 	if(uip_len > 0) {
 	  uip_arp_out();
-	  tapdev_send();
+	  output();
 	}
       }
+#endif /* UIP_TCP_TIMER_WHEEL */
 
 #if UIP_UDP
       for(i = 0; i < UIP_UDP_CONNS; i++) {
@@ -139,7 +334,7 @@ main(void)
 	   uip_len is set to a value > 0. */
 	if(uip_len > 0) {
 	  uip_arp_out();
-	  tapdev_send();
+	  output();
 	}
       }
 #endif /* UIP_UDP */
@@ -150,6 +345,19 @@ main(void)
 	uip_arp_timer();
       }
     }
+#if UIP_PACKETS > 1
+    flush();
+#endif /* UIP_PACKETS > 1 */
+    tapdev_flush();
+
+    if(idle) {
+      /* Sleep until a frame arrives or the periodic timer is due. */
+#if UIP_TCP_CLOCK_RTO
+      eventloop_wait(uip_rexmit_remaining(timer_remaining(&periodic_timer)));
+#else /* UIP_TCP_CLOCK_RTO */
+      eventloop_wait(timer_remaining(&periodic_timer));
+#endif /* UIP_TCP_CLOCK_RTO */
+    }
   }
   return 0;
 }
@@ -39,7 +39,9 @@
 #define UIP_DRIPADDR2   0
 #define UIP_DRIPADDR3   1
 
+#include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -61,10 +63,48 @@
 #endif /* linux */
 
 #include "uip.h"
+#include "tapdev.h"
+
+/* In batched mode, all frames that are waiting are read from the tap
+   device whenever select() reports it readable, and outbound frames
+   are held until tapdev_flush() is called. TAPDEV_BATCH is the
+   maximum number of frames held in each direction. */
+#ifdef TAPDEV_CONF_BATCH
+#define TAPDEV_BATCH TAPDEV_CONF_BATCH
+#else /* TAPDEV_CONF_BATCH */
+#define TAPDEV_BATCH 1
+#endif /* TAPDEV_CONF_BATCH */
 
 static int drop = 0;
 static int fd;
 
+#if TAPDEV_BATCH > 1
+struct frame {
+  unsigned int len;
+  u8_t buf[UIP_BUFSIZE];
+#if UIP_ZEROCOPY
+  /* Data sent with uip_sendref() is not copied into the frame; the
+     frame holds the headers and the data is gathered from here. */
+  const void *ref;
+  unsigned int reflen;
+#endif /* UIP_ZEROCOPY */
+};
+
+static struct frame rxframes[TAPDEV_BATCH], txframes[TAPDEV_BATCH];
+static int rxnext, rxcount, txcount;
+
+struct tapdev_stats tapdev_stats;
+
+static volatile sig_atomic_t dump_stats;
+
+/*---------------------------------------------------------------------------*/
+static void
+request_stats(int sig)
+{
+  dump_stats = 1;
+}
+#endif /* TAPDEV_BATCH > 1 */
+
 
 /*---------------------------------------------------------------------------*/
 void
@@ -94,29 +134,180 @@ tapdev_init(void)
 	   UIP_DRIPADDR0, UIP_DRIPADDR1, UIP_DRIPADDR2, UIP_DRIPADDR3);
   system(buf);
 
+  /* The main loop waits for the device to become readable in the
+     event loop, and then reads frames until there are no more, so
+     reads must not block. */
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+#if TAPDEV_BATCH > 1
+  /* The counters are printed on SIGUSR1. */
+  signal(SIGUSR1, request_stats);
+#endif /* TAPDEV_BATCH > 1 */
 }
 /*---------------------------------------------------------------------------*/
-unsigned int
-tapdev_read(void)
+int
+tapdev_fd(void)
+{
+  return fd;
+}
+/*---------------------------------------------------------------------------*/
+static int
+readable(void)
 {
   fd_set fdset;
-  struct timeval tv, now;
-  int ret;
-  
-  tv.tv_sec = 0;
-  tv.tv_usec = 1000;
+  struct timeval tv;
 
+  tv.tv_sec = 0;
+  tv.tv_usec = 0;
 
   FD_ZERO(&fdset);
   FD_SET(fd, &fdset);
 
-  ret = select(fd + 1, &fdset, NULL, NULL, &tv);
-  if(ret == 0) {
-    return 0;
+  return select(fd + 1, &fdset, NULL, NULL, &tv) > 0;
+}
+/*---------------------------------------------------------------------------*/
+#if TAPDEV_BATCH > 1
+static void
+fill(void)
+{
+  int ret;
+
+  rxnext = rxcount = 0;
+  while(rxcount < TAPDEV_BATCH) {
+    ret = read(fd, rxframes[rxcount].buf, UIP_BUFSIZE);
+    if(ret <= 0) {
+      if(ret == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+	perror("tap_dev: tapdev_read: read");
+      }
+      break;
+    }
+    rxframes[rxcount].len = ret;
+    ++rxcount;
+  }
+
+  if(rxcount > 0) {
+    ++tapdev_stats.rxwakeups;
+    tapdev_stats.rxframes += rxcount;
+    if(rxcount > tapdev_stats.rxmaxbatch) {
+      tapdev_stats.rxmaxbatch = rxcount;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+unsigned int
+tapdev_read(void)
+{
+  struct frame *f;
+
+  if(dump_stats) {
+    dump_stats = 0;
+    printf("tapdev: %lu frames in %lu wakeups (max %lu), "
+	   "%lu frames in %lu flushes (max %lu), %lu dropped\n",
+	   tapdev_stats.rxframes, tapdev_stats.rxwakeups,
+	   tapdev_stats.rxmaxbatch,
+	   tapdev_stats.txframes, tapdev_stats.txflushes,
+	   tapdev_stats.txmaxbatch, tapdev_stats.txdrop);
   }
+
+  if(rxnext == rxcount) {
+    fill();
+    if(rxcount == 0) {
+      return 0;
+    }
+  }
+
+  f = &rxframes[rxnext++];
+  memcpy(uip_buf, f->buf, f->len);
+  return f->len;
+}
+/*---------------------------------------------------------------------------*/
+int
+tapdev_poll(void)
+{
+  return rxnext < rxcount || readable();
+}
+/*---------------------------------------------------------------------------*/
+void
+tapdev_send(void)
+{
+  if(txcount == TAPDEV_BATCH) {
+    tapdev_flush();
+  }
+#if UIP_ZEROCOPY
+  txframes[txcount].len = uip_len - uip_reflen;
+  txframes[txcount].ref = uip_appdata;
+  txframes[txcount].reflen = uip_reflen;
+  memcpy(txframes[txcount].buf, uip_buf, uip_len - uip_reflen);
+  if(uip_reflen > 0 && (u8_t *)uip_appdata >= &uip_buf[0] &&
+     (u8_t *)uip_appdata < &uip_buf[UIP_BUFSIZE]) {
+    /* The data is in uip_buf, which is reused before the frame is
+       written, so it is copied into the frame after the headers. */
+    memcpy(txframes[txcount].buf + txframes[txcount].len, uip_appdata,
+	   uip_reflen);
+    txframes[txcount].len = uip_len;
+    txframes[txcount].reflen = 0;
+  }
+#else /* UIP_ZEROCOPY */
+  txframes[txcount].len = uip_len;
+  memcpy(txframes[txcount].buf, uip_buf, uip_len);
+#endif /* UIP_ZEROCOPY */
+  ++txcount;
+}
+/*---------------------------------------------------------------------------*/
+void
+tapdev_flush(void)
+{
+  int i, ret;
+#if UIP_ZEROCOPY
+  struct iovec iov[2];
+#endif /* UIP_ZEROCOPY */
+
+  if(txcount == 0) {
+    return;
+  }
+
+  for(i = 0; i < txcount; ++i) {
+#if UIP_ZEROCOPY
+    iov[0].iov_base = txframes[i].buf;
+    iov[0].iov_len = txframes[i].len;
+    iov[1].iov_base = (void *)txframes[i].ref;
+    iov[1].iov_len = txframes[i].reflen;
+    ret = writev(fd, iov, txframes[i].reflen > 0? 2: 1);
+#else /* UIP_ZEROCOPY */
+    ret = write(fd, txframes[i].buf, txframes[i].len);
+#endif /* UIP_ZEROCOPY */
+    if(ret == -1) {
+      if(errno == EAGAIN || errno == EWOULDBLOCK) {
+	/* The device queue is full, so the frame is lost like it
+	   would be on a busy link. */
+	++tapdev_stats.txdrop;
+	continue;
+      }
+      perror("tap_dev: tapdev_flush: write");
+      exit(1);
+    }
+  }
+
+  ++tapdev_stats.txflushes;
+  tapdev_stats.txframes += txcount;
+  if(txcount > tapdev_stats.txmaxbatch) {
+    tapdev_stats.txmaxbatch = txcount;
+  }
+  txcount = 0;
+}
+/*---------------------------------------------------------------------------*/
+#else /* TAPDEV_BATCH > 1 */
+unsigned int
+tapdev_read(void)
+{
+  int ret;
+
   ret = read(fd, uip_buf, UIP_BUFSIZE);
   if(ret == -1) {
-    perror("tap_dev: tapdev_read: read");
+    if(errno != EAGAIN && errno != EWOULDBLOCK) {
+      perror("tap_dev: tapdev_read: read");
+    }
+    return 0;
   }
 
   /*  printf("--- tap_dev: tapdev_read: read %d bytes\n", ret);*/
@@ -131,10 +322,19 @@ tapdev_read(void)
   return ret;
 }
 /*---------------------------------------------------------------------------*/
+int
+tapdev_poll(void)
+{
+  return readable();
+}
+/*---------------------------------------------------------------------------*/
 void
 tapdev_send(void)
 {
   int ret;
+#if UIP_ZEROCOPY
+  struct iovec iov[2];
+#endif /* UIP_ZEROCOPY */
   /*  printf("tapdev_send: sending %d bytes\n", size);*/
   /*  check_checksum(uip_buf, size);*/
 
@@ -143,10 +343,26 @@ tapdev_send(void)
     printf("Dropped a packet!\n");
     return;
     }*/
+#if UIP_ZEROCOPY
+  /* The headers are in uip_buf, and the data of a segment sent with
+     uip_sendref() is gathered from where the application keeps it. */
+  iov[0].iov_base = uip_buf;
+  iov[0].iov_len = uip_len - uip_reflen;
+  iov[1].iov_base = uip_appdata;
+  iov[1].iov_len = uip_reflen;
+  ret = writev(fd, iov, uip_reflen > 0? 2: 1);
+#else /* UIP_ZEROCOPY */
   ret = write(fd, uip_buf, uip_len);
+#endif /* UIP_ZEROCOPY */
   if(ret == -1) {
     perror("tap_dev: tapdev_send: writev");
     exit(1);
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+tapdev_flush(void)
+{
+}
+#endif /* TAPDEV_BATCH > 1 */
+/*---------------------------------------------------------------------------*/
@@ -39,7 +39,26 @@
 #define __TAPDEV_H__
 
 void tapdev_init(void);
+int tapdev_fd(void);
 unsigned int tapdev_read(void);
+int tapdev_poll(void);
 void tapdev_send(void);
+void tapdev_flush(void);
+
+/* Counters for the batched mode (TAPDEV_CONF_BATCH > 1). The average
+   number of frames per wakeup is rxframes / rxwakeups, and the
+   average number of frames per flush is txframes / txflushes. */
+struct tapdev_stats {
+  unsigned long rxwakeups;   /* Wakeups in which frames were read. */
+  unsigned long rxframes;    /* Frames read. */
+  unsigned long rxmaxbatch;  /* Most frames read in one wakeup. */
+  unsigned long txflushes;   /* Flushes in which frames were sent. */
+  unsigned long txframes;    /* Frames sent. */
+  unsigned long txmaxbatch;  /* Most frames sent in one flush. */
+  unsigned long txdrop;      /* Frames dropped since the device was
+				busy. */
+};
+
+extern struct tapdev_stats tapdev_stats;
 
 #endif /* __TAPDEV_H__ */
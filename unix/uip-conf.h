@@ -75,6 +75,16 @@ typedef uint8_t u8_t;
  */
 typedef uint16_t u16_t;
 
+/**
+ * 32 bit datatype
+ *
+ * This typedef defines the 32-bit type used by uIP when
+ * UIP_CONF_TCP_SEQ32 is set.
+ *
+ * \hideinitializer
+ */
+typedef uint32_t u32_t;
+
 /**
  * Statistics datatype
  *
@@ -141,6 +151,30 @@ typedef unsigned short uip_stats_t;
  */
 #define UIP_CONF_STATISTICS      1
 
+/**
+ * Use the checksum functions in uip_arch.c, which sum 32-bit words
+ * into a 64-bit accumulator, instead of the generic ones in uip.c.
+ *
+ * \hideinitializer
+ */
+#define UIP_ARCH_CHKSUM          1
+
+/**
+ * Number of frames the tap driver reads per wakeup and holds for
+ * transmission until the end of the main loop iteration.
+ *
+ * \hideinitializer
+ */
+#define TAPDEV_CONF_BATCH        16
+
+/**
+ * Size of the buffer in which the web server collects the response
+ * headers.
+ *
+ * \hideinitializer
+ */
+#define HTTPD_CONF_OUTBUF_SIZE   132
+
 /* Here we include the header file for the application(s) we use in
    our project. */
 /*#include "smtp.h"*/
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2006, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the uIP TCP/IP stack
+ *
+ */
+
+/**
+ * \file
+ *         Checksum functions for 32- and 64-bit hosts
+ *
+ *         The generic checksum code in uip.c adds one 16-bit word at a
+ *         time and checks for a carry after every addition. On a host
+ *         with a wide accumulator, the one's complement sum can instead
+ *         be computed by adding whole 32-bit words in the native byte
+ *         order into a 64-bit accumulator, and folding the carries back
+ *         in once at the end (RFC1071). On x86, the words are added
+ *         with SSE2 or, if the CPU supports it, AVX2 instructions.
+ */
+
+#include "uip.h"
+#include "uip_arch.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX2 1
+#endif
+
+#define BUF ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/* Shorter buffers, such as the IP header, are summed with the scalar
+   code since the vector code would not get through a single round. */
+#define VECTOR_MIN_LEN 64
+
+/*---------------------------------------------------------------------------*/
+static uint64_t
+sum_scalar(const u8_t *data, u16_t len)
+{
+  uint64_t acc;
+  uint32_t w[4];
+  u16_t w16;
+  u8_t last[2];
+
+  acc = 0;
+  while(len >= 16) {
+    memcpy(w, data, 16);
+    acc += (uint64_t)w[0] + w[1] + w[2] + w[3];
+    data += 16;
+    len -= 16;
+  }
+  while(len >= 4) {
+    memcpy(w, data, 4);
+    acc += w[0];
+    data += 4;
+    len -= 4;
+  }
+  if(len >= 2) {
+    memcpy(&w16, data, 2);
+    acc += w16;
+    data += 2;
+    len -= 2;
+  }
+  if(len == 1) {
+    /* The last byte is padded with a zero byte to a full 16-bit
+       word. */
+    last[0] = data[0];
+    last[1] = 0;
+    memcpy(&w16, last, 2);
+    acc += w16;
+  }
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+#ifdef __SSE2__
+static uint64_t
+sum_sse2(const u8_t *data, u16_t len)
+{
+  __m128i acc, zero, v;
+  uint32_t lanes[4];
+
+  /* Each of the 32-bit lanes gets two 16-bit words per round, so they
+     cannot overflow for any buffer shorter than 64 kilobytes. */
+  acc = zero = _mm_setzero_si128();
+  while(len >= 16) {
+    v = _mm_loadu_si128((const __m128i *)data);
+    acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+    acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+    data += 16;
+    len -= 16;
+  }
+  _mm_storeu_si128((__m128i *)lanes, acc);
+  return (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+    sum_scalar(data, len);
+}
+#endif /* __SSE2__ */
+/*---------------------------------------------------------------------------*/
+#if HAVE_AVX2
+__attribute__((target("avx2")))
+static uint64_t
+sum_avx2(const u8_t *data, u16_t len)
+{
+  __m256i acc, zero, v;
+  uint32_t lanes[8];
+
+  acc = zero = _mm256_setzero_si256();
+  while(len >= 32) {
+    v = _mm256_loadu_si256((const __m256i *)data);
+    acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+    acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+    data += 32;
+    len -= 32;
+  }
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+  return (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+    lanes[4] + lanes[5] + lanes[6] + lanes[7] +
+    sum_scalar(data, len);
+}
+#endif /* HAVE_AVX2 */
+/*---------------------------------------------------------------------------*/
+static uint64_t sum_select(const u8_t *data, u16_t len);
+
+static uint64_t (* sum_vector)(const u8_t *data, u16_t len) = sum_select;
+
+/* The first call picks the fastest implementation the CPU supports. */
+static uint64_t
+sum_select(const u8_t *data, u16_t len)
+{
+  sum_vector = sum_scalar;
+#ifdef __SSE2__
+  sum_vector = sum_sse2;
+#endif /* __SSE2__ */
+#if HAVE_AVX2
+  if(__builtin_cpu_supports("avx2")) {
+    sum_vector = sum_avx2;
+  }
+#endif /* HAVE_AVX2 */
+  return sum_vector(data, len);
+}
+/*---------------------------------------------------------------------------*/
+static u16_t
+chksum(u16_t sum, const u8_t *data, u16_t len)
+{
+  uint64_t acc;
+  uint32_t s;
+
+  if(len < VECTOR_MIN_LEN) {
+    acc = sum_scalar(data, len);
+  } else {
+    acc = sum_vector(data, len);
+  }
+
+  /* Fold the carries back in. The one's complement sum is the same
+     in either byte order, so the result only has to be swapped into
+     host byte order at the end. */
+  while(acc >> 16) {
+    acc = (acc >> 16) + (acc & 0xffff);
+  }
+  s = (uint32_t)htons((u16_t)acc) + sum;
+  s = (s >> 16) + (s & 0xffff);
+
+  /* Return sum in host byte order. */
+  return (u16_t)s;
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_chksum(u16_t *data, u16_t len)
+{
+  return htons(chksum(0, (u8_t *)data, len));
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_ipchksum(void)
+{
+  u16_t sum;
+
+  sum = chksum(0, &uip_buf[UIP_LLH_LEN], UIP_IPH_LEN);
+  return (sum == 0) ? 0xffff : htons(sum);
+}
+/*---------------------------------------------------------------------------*/
+static u16_t
+upper_layer_chksum(u8_t proto)
+{
+  u16_t upper_layer_len;
+  u16_t sum;
+
+#if UIP_CONF_IPV6
+  upper_layer_len = (((u16_t)(BUF->len[0]) << 8) + BUF->len[1]);
+#else /* UIP_CONF_IPV6 */
+  upper_layer_len = (((u16_t)(BUF->len[0]) << 8) + BUF->len[1]) - UIP_IPH_LEN;
+#endif /* UIP_CONF_IPV6 */
+
+  /* IP protocol and length fields. This addition cannot carry. */
+  sum = upper_layer_len + proto;
+  /* Sum IP source and destination addresses. */
+  sum = chksum(sum, (u8_t *)&BUF->srcipaddr[0], 2 * sizeof(uip_ipaddr_t));
+
+  /* Sum TCP header and data. */
+#if UIP_ZEROCOPY
+  sum = chksum(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+	       upper_layer_len - uip_reflen);
+  if(uip_reflen > 0) {
+    if(uip_refsumlen == uip_reflen) {
+      /* The application has supplied the sum of the data. */
+      sum += uip_refsum;
+      if(sum < uip_refsum) {
+	++sum;
+      }
+    } else {
+      sum = chksum(sum, (u8_t *)uip_appdata, uip_reflen);
+    }
+  }
+#else /* UIP_ZEROCOPY */
+  sum = chksum(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+	       upper_layer_len);
+#endif /* UIP_ZEROCOPY */
+
+  return (sum == 0) ? 0xffff : htons(sum);
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_CONF_IPV6
+u16_t
+uip_icmp6chksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_ICMP6);
+}
+#endif /* UIP_CONF_IPV6 */
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_tcpchksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_TCP);
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_UDP_CHECKSUMS
+u16_t
+uip_udpchksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_UDP);
+}
+#endif /* UIP_UDP_CHECKSUMS */
+/*---------------------------------------------------------------------------*/